@@ -3,7 +3,24 @@
  * Date: Jan 30 2021
  * Description: A generic, thread-safe FIFO buffer. Buffers data pointers. Includes priority functionality
  * **/
-#include "fifo.h"
+#include "fifo_internal.h"
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+//Monotonic clock in nanoseconds, used to age queued nodes
+uint64_t fifoNowNs(void) 
+{
+#if FIFO_ENABLE_STATS
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
 
 //linked list manipulation functions
 void addNodeAfter(fifo_node_t* curr_node, fifo_node_t* new_node) 
@@ -42,6 +59,8 @@ fifo_node_t* fifoNodeCreate(void* data, int priority)
     node_out->data = data;
     node_out->next = NULL;
     node_out->prev = NULL;
+    node_out->keyed = false;
+    node_out->enqueue_ns = fifoNowNs();
 
     return node_out;
 }
@@ -54,33 +73,802 @@ void* fifoNodeDestroy(fifo_node_t* node)
     return out;
 }
 
-fifo_buffer_t* fifoBufferInit(int max_buffer_size) 
+/////////////////////////////// Real-time mode
+// Nodes come from a pool of max_buffer_size nodes allocated and locked into memory at init,
+// so no push or pull allocates or page-faults. Priorities are bucketed into
+// FIFO_RT_PRIO_LEVELS levels; the head-most node of every level and a bitmap of non-empty
+// levels locate any insertion point in a constant number of steps.
+
+typedef struct Realtime {
+    fifo_node_t* pool;                              //one block of max_buffer_size nodes
+    fifo_node_t* free_nodes;                        //unused pool nodes, linked through next
+    uint64_t levels_used;                           //bit l set if level_head[l] != NULL
+    fifo_node_t* level_head[FIFO_RT_PRIO_LEVELS];   //head-most (newest) node of each level
+    fifo_node_t* negative_head;                     //head-most (oldest) node of negative priority
+} fifo_realtime_t;
+
+//Real-time blocks are page-aligned and padded to whole pages, so munlock of one never
+//unlocks a page shared with another allocation
+static size_t fifoRtRound(size_t size) 
+{
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+static void* fifoRtAlloc(size_t size) 
+{
+    void* block;
+    if (posix_memalign(&block, (size_t) sysconf(_SC_PAGESIZE), fifoRtRound(size)) != 0) return NULL;
+    memset(block, 0, fifoRtRound(size));
+    return block;
+}
+
+//Locks everything a push or pull touches: the buffer (with its lock and conditions), the
+//sentinel, this struct and the pool. buffer and sentinel must come from fifoRtAlloc
+static fifo_realtime_t* fifoRtCreate(fifo_buffer_t* buffer, int max_buffer_size) 
+{
+    fifo_realtime_t* rt = (fifo_realtime_t*) fifoRtAlloc(sizeof(fifo_realtime_t));
+    if (rt == NULL) return NULL;
+    rt->pool = (fifo_node_t*) fifoRtAlloc((size_t) (max_buffer_size > 0 ? max_buffer_size : 1) * sizeof(fifo_node_t));
+    if (rt->pool == NULL) 
+    {
+        free(rt);
+        return NULL;
+    }
+    for (int i = 0; i < max_buffer_size; i++) 
+    {
+        rt->pool[i].next = rt->free_nodes;
+        rt->free_nodes = &rt->pool[i];
+    }
+
+    //Failure is not fatal: the buffer works, it can just still take page faults
+    if (mlock(buffer, fifoRtRound(sizeof(fifo_buffer_t))) != 0 || mlock(buffer->sentinel, fifoRtRound(sizeof(fifo_node_t))) != 0 
+        || mlock(rt, fifoRtRound(sizeof(fifo_realtime_t))) != 0 || mlock(rt->pool, fifoRtRound((size_t) max_buffer_size * sizeof(fifo_node_t))) != 0) 
+    {
+        perror("fifo: mlock of real-time buffer failed");
+    }
+    return rt;
+}
+
+//Call before buffer and sentinel are freed
+static void fifoRtDestroy(fifo_buffer_t* buffer, int max_buffer_size) 
+{
+    fifo_realtime_t* rt = buffer->rt;
+    munlock(rt->pool, fifoRtRound((size_t) max_buffer_size * sizeof(fifo_node_t)));
+    munlock(rt, fifoRtRound(sizeof(fifo_realtime_t)));
+    munlock(buffer->sentinel, fifoRtRound(sizeof(fifo_node_t)));
+    munlock(buffer, fifoRtRound(sizeof(fifo_buffer_t)));
+    free(rt->pool);
+    free(rt);
+}
+
+//Takes a pool node. Capacity bounds occupancy, so the pool cannot run dry. Caller holds the lock
+static fifo_node_t* fifoRtNodeGetLocked(fifo_buffer_t* buffer, void* data, int priority) 
+{
+    fifo_node_t* node = buffer->rt->free_nodes;
+    buffer->rt->free_nodes = node->next;
+    node->data = data;
+    node->priority = priority;
+    node->next = NULL;
+    node->prev = NULL;
+    node->keyed = false;
+    node->enqueue_ns = fifoNowNs();
+    return node;
+}
+
+#if FIFO_ENABLE_PRIORITY
+static int fifoRtLevel(int priority) 
+{
+    return priority < FIFO_RT_PRIO_LEVELS ? priority : FIFO_RT_PRIO_LEVELS - 1;
+}
+
+/**Links new_node in O(1): before the head-most node of its level, or of the next non-empty
+ * level above it, or of the negative priorities. Same order as fifoInsertLocked, except that
+ * priorities of FIFO_RT_PRIO_LEVELS-1 and above form one level. **/
+static void fifoRtLinkLocked(fifo_buffer_t* buffer, fifo_node_t* new_node) 
+{
+    fifo_realtime_t* rt = buffer->rt;
+    if (new_node->priority < 0) 
+    {
+        addNodeAfter(buffer->sentinel->prev,new_node);
+        if (rt->negative_head == NULL) rt->negative_head = new_node;
+        return;
+    }
+    int level = fifoRtLevel(new_node->priority);
+    fifo_node_t* before = rt->level_head[level];
+    if (before == NULL) 
+    {
+        uint64_t above = level + 1 < 64 ? rt->levels_used & (~0ull << (level + 1)) : 0;
+        if (above != 0) before = rt->level_head[__builtin_ctzll(above)];
+        else before = rt->negative_head != NULL ? rt->negative_head : buffer->sentinel;
+    }
+    addNodeAfter(before->prev,new_node);
+    rt->level_head[level] = new_node;
+    rt->levels_used |= 1ull << level;
+}
+
+//Level bookkeeping for a node just unlinked from the tail. Caller holds the lock
+static void fifoRtUnlinkedLocked(fifo_buffer_t* buffer, fifo_node_t* node) 
+{
+    fifo_realtime_t* rt = buffer->rt;
+    if (node->priority < 0) 
+    {
+        if (rt->negative_head == node) rt->negative_head = NULL;
+    } //the tail-most negative node is also the head-most only if it is the last one
+    else 
+    {
+        int level = fifoRtLevel(node->priority);
+        if (rt->level_head[level] == node) 
+        {
+            rt->level_head[level] = NULL;
+            rt->levels_used &= ~(1ull << level);
+        }
+    }
+}
+#endif
+
+/**Returns node to the real-time pool and NULL, or node itself for the caller to free
+ * outside the lock. Caller holds the lock **/
+static fifo_node_t* fifoNodeRecycleLocked(fifo_buffer_t* buffer, fifo_node_t* node) 
+{
+    if (buffer->rt == NULL) return node;
+    node->next = buffer->rt->free_nodes;
+    buffer->rt->free_nodes = node;
+    return NULL;
+}
+
+/////////////////////////////// Priority lanes
+// fifoPullMinPriority callers wait in one lane per threshold, each with its own condition.
+// A push signals only the lanes its priority qualifies for, so fast-lane consumers are not
+// woken by the ordinary traffic on cond_nonempty. Lanes live until the buffer is closed.
+
+typedef struct Lane {
+    struct Lane* next;
+    int threshold;
+    fifo_cond_t cond;
+} fifo_lane_t;
+
+//Wakes one waiter of every lane that an item of this priority qualifies for. Caller holds the lock
+static void fifoLanesSignalLocked(fifo_buffer_t* buffer, int priority) 
+{
+    for (fifo_lane_t* lane = buffer->lanes; lane != NULL; lane = lane->next) 
+    {
+        if (priority < 0 || priority >= lane->threshold) fifoCondSignal(&lane->cond);
+    }
+}
+
+//Returns the lane for threshold, creating it if needed. Caller holds the lock
+static fifo_lane_t* fifoLaneGetLocked(fifo_buffer_t* buffer, int threshold) 
+{
+    fifo_lane_t* lane;
+    for (lane = buffer->lanes; lane != NULL; lane = lane->next) 
+    {
+        if (lane->threshold == threshold) return lane;
+    }
+    lane = (fifo_lane_t*) malloc(sizeof(fifo_lane_t));
+    if (lane == NULL) return NULL;
+    lane->threshold = threshold;
+    fifoCondInit(&lane->cond);
+    fifoCondBind(&lane->cond, &buffer->lock);
+    lane->next = buffer->lanes;
+    buffer->lanes = lane;
+    return lane;
+}
+
+/**Links new_node into the list according to its priority and updates occupancy.
+ * Caller holds the lock and has verified the buffer has room. **/
+static void fifoInsertLocked(fifo_buffer_t* buffer, fifo_node_t* new_node) 
+{
+#if !FIFO_ENABLE_PRIORITY
+    addNodeAfter(buffer->sentinel,new_node); //priority disabled: plain FIFO append at head
+#else
+    if (buffer->rt != NULL) 
+    {
+        fifoRtLinkLocked(buffer, new_node);
+    } //real-time mode: bounded steps
+    else if (buffer->pull_order != FIFO_ORDER_FIFO) 
+    {
+        addNodeAfter(buffer->sentinel,new_node);
+    } //LIFO and mixed orders ignore priorities: the head is the newest end
+    else if (new_node->priority < 0) 
+    {
+        addNodeAfter(buffer->sentinel->prev,new_node);
+    } //Negative priorities are considered higher than any existing. Append to tail
+    else 
+    {
+        //loop through buffer until a node of equal or higher priority is found.
+        fifo_node_t* p;
+        for (p = buffer->sentinel->next; p != buffer->sentinel;p = p->next) 
+        {
+            if (p->priority >= new_node->priority || p->priority < 0) break;
+        }
+        addNodeAfter(p->prev,new_node);
+    } //For non-negative priorities, find node of equal or greater priority. Insert new node before.
+#endif
+
+    if (buffer->lanes != NULL) fifoLanesSignalLocked(buffer, new_node->priority);
+    buffer->buffer_occupancy++;
+#if FIFO_ENABLE_STATS
+    buffer->stats.pushes++;
+    if (buffer->buffer_occupancy > buffer->stats.peak_occupancy) buffer->stats.peak_occupancy = buffer->buffer_occupancy;
+#endif
+}
+
+#if FIFO_ENABLE_PRIORITY
+/**Stable bottom-up merge sort of nodes by ascending priority. tmp must hold count pointers **/
+static void fifoSortNodes(fifo_node_t** nodes, fifo_node_t** tmp, int count) 
 {
-    fifo_buffer_t *buffer = (fifo_buffer_t*) malloc(sizeof(fifo_buffer_t));
+    for (int width = 1; width < count; width *= 2) 
+    {
+        for (int lo = 0; lo < count; lo += 2 * width) 
+        {
+            int mid = lo + width < count ? lo + width : count;
+            int hi = lo + 2 * width < count ? lo + 2 * width : count;
+            int i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) tmp[k++] = nodes[j]->priority < nodes[i]->priority ? nodes[j++] : nodes[i++];
+            while (i < mid) tmp[k++] = nodes[i++];
+            while (j < hi) tmp[k++] = nodes[j++];
+        }
+        for (int i = 0; i < count; i++) nodes[i] = tmp[i];
+    }
+}
+#endif
+
+/**Links count nodes, given in push order, in one pass over the list. The result is identical
+ * to calling fifoInsertLocked on each node in order. nodes is reordered; tmp must hold count
+ * pointers. Does not touch occupancy or stats. Caller holds the lock. **/
+static void fifoLinkBatchLocked(fifo_buffer_t* buffer, fifo_node_t** nodes, fifo_node_t** tmp, int count) 
+{
+    if (count <= 0) return;
+#if !FIFO_ENABLE_PRIORITY
+    (void) tmp;
+#else
+    if (buffer->pull_order != FIFO_ORDER_FIFO) 
+#endif
+    {
+        for (int i = 0; i < count; i++) addNodeAfter(buffer->sentinel,nodes[i]);
+        return;
+    } //plain append at head
+#if FIFO_ENABLE_PRIORITY
+    //Negative priorities go to the tail in push order; partition them out first
+    int n = 0;
+    for (int i = 0; i < count; i++) 
+    {
+        if (nodes[i]->priority < 0) addNodeAfter(buffer->sentinel->prev,nodes[i]);
+        else nodes[n++] = nodes[i];
+    }
+
+    //A later push lands in front of earlier pushes of equal priority. Reversing before the
+    //stable sort yields (priority ascending, push order descending), i.e. head-to-tail order
+    for (int i = 0; i < n / 2; i++) 
+    {
+        fifo_node_t* t = nodes[i];
+        nodes[i] = nodes[n - 1 - i];
+        nodes[n - 1 - i] = t;
+    }
+    fifoSortNodes(nodes, tmp, n);
+
+    //Single walk: each node goes before the first node of equal or higher priority
+    fifo_node_t* p = buffer->sentinel->next;
+    for (int i = 0; i < n; i++) 
+    {
+        while (p != buffer->sentinel && p->priority >= 0 && p->priority < nodes[i]->priority) p = p->next;
+        addNodeAfter(p->prev,nodes[i]);
+    }
+#endif
+}
+
+/**Lazy priority mode: merges the unsorted staging area into the ordered list. Staged nodes
+ * are already counted in occupancy. Caller holds the lock. **/
+static void fifoStagingMergeLocked(fifo_buffer_t* buffer) 
+{
+    if (buffer->staging_count == 0) return;
+    fifoLinkBatchLocked(buffer, buffer->staging, buffer->staging + buffer->lazy_threshold, buffer->staging_count);
+    buffer->staging_count = 0;
+}
+
+/**Lazy priority mode: O(1) append of new_node to the staging area. The area is merged when it
+ * reaches lazy_threshold or when an ordered view is needed. Caller holds the lock and has
+ * verified the buffer has room. **/
+static void fifoStageLocked(fifo_buffer_t* buffer, fifo_node_t* new_node) 
+{
+    buffer->staging[buffer->staging_count++] = new_node;
+    if (buffer->staging_count == buffer->lazy_threshold) fifoStagingMergeLocked(buffer);
+
+    if (buffer->lanes != NULL) fifoLanesSignalLocked(buffer, new_node->priority);
+    buffer->buffer_occupancy++;
+#if FIFO_ENABLE_STATS
+    buffer->stats.pushes++;
+    if (buffer->buffer_occupancy > buffer->stats.peak_occupancy) buffer->stats.peak_occupancy = buffer->buffer_occupancy;
+#endif
+}
+
+/**As fifoLinkBatchLocked, and accounts for the new nodes. Staged nodes were pushed earlier,
+ * so they are merged first. Caller holds the lock and has verified the buffer has room. **/
+static void fifoMergeLocked(fifo_buffer_t* buffer, fifo_node_t** nodes, fifo_node_t** tmp, int count) 
+{
+    if (count <= 0) return;
+    fifoStagingMergeLocked(buffer);
+    fifoLinkBatchLocked(buffer, nodes, tmp, count);
+
+    if (buffer->lanes != NULL) for (int i = 0; i < count; i++) fifoLanesSignalLocked(buffer, nodes[i]->priority);
+    buffer->buffer_occupancy += count;
+#if FIFO_ENABLE_STATS
+    buffer->stats.pushes += count;
+    if (buffer->buffer_occupancy > buffer->stats.peak_occupancy) buffer->stats.peak_occupancy = buffer->buffer_occupancy;
+#endif
+}
+
+/**Moves items pushed with fifoPushSignalSafe from the signal ring into the list, in arrival
+ * order, while the buffer has room. Caller holds the lock **/
+static void fifoSignalDrainLocked(fifo_buffer_t* buffer) 
+{
+    void* data;
+    int priority;
+    int drained = 0;
+    while (buffer->buffer_occupancy < buffer->max_buffer_size && fifoSignalRingPop(buffer->signal_ring, &data, &priority)) 
+    {
+        fifo_node_t* node = buffer->rt != NULL ? fifoRtNodeGetLocked(buffer, data, priority) : fifoNodeCreate(data, priority);
+        if (buffer->staging != NULL) fifoStageLocked(buffer, node);
+        else fifoInsertLocked(buffer, node);
+        drained++;
+    }
+    if (drained > 1) fifoCondBroadcast(&buffer->cond_nonempty); //the drainer may have absorbed the producers' signals
+}
+
+/**True if pulls by the calling thread take from the head (newest) end of the list **/
+static bool fifoPullsFromHead(fifo_buffer_t* buffer) 
+{
+    switch (buffer->pull_order) 
+    {
+        case FIFO_ORDER_LIFO: return true;
+        case FIFO_ORDER_MIXED: return buffer->has_owner && pthread_equal(buffer->owner, pthread_self());
+        default: return false;
+    }
+}
+
+/**Unlinks the node at the tail of a non-empty buffer, or at the head if from_head is set,
+ * and updates occupancy. Caller holds the lock **/
+static fifo_node_t* fifoRemoveLocked(fifo_buffer_t* buffer, bool from_head) 
+{
+    fifoStagingMergeLocked(buffer); //lazy mode: ordering work happens here, on the consumer side
+    fifo_node_t* rec = removeNode(buffer, from_head ? buffer->sentinel->next : buffer->sentinel->prev);
+#if FIFO_ENABLE_PRIORITY
+    if (buffer->rt != NULL) fifoRtUnlinkedLocked(buffer, rec);
+#endif
+    if (rec->keyed) fifoDedupRemove(buffer->dedup, rec->key);
+    
+    buffer->buffer_occupancy--;
+#if FIFO_ENABLE_STATS
+    buffer->stats.pulls++;
+#endif
+    return rec;
+}
+
+/////////////////////////////// Direct hand-off
+/**If a consumer is parked, gives it data and unlinks it from the waiter queue. Returns the
+ * waiter, which the caller must pass to fifoWaiterWake, or NULL if nobody is parked.
+ * Caller holds the lock. Parked consumers exist only while the buffer is empty, so the
+ * data is the next element whatever its priority. **/
+static fifo_waiter_t* fifoHandoffLocked(fifo_buffer_t* buffer, void* data) 
+{
+    fifo_waiter_t* waiter = buffer->waiters_head;
+    if (waiter == NULL) return NULL;
+
+    buffer->waiters_head = waiter->next;
+    if (buffer->waiters_head == NULL) buffer->waiters_tail = NULL;
+    waiter->data = data;
+#if FIFO_ENABLE_STATS
+    buffer->stats.pushes++;
+    buffer->stats.pulls++;
+    buffer->stats.handoffs++;
+#endif
+    return waiter;
+}
+
+//Publishes the hand-off. The waiter may return and release its stack frame as soon as filled is set
+static void fifoWaiterWake(fifo_waiter_t* waiter) 
+{
+    atomic_store_explicit(&waiter->filled, 1, memory_order_release);
+    fifoFutexWake(&waiter->filled, 1);
+}
+
+/**Parks the calling consumer on an empty buffer. Releases the lock, sleeps on the waiter's
+ * own futex word until a producer fills it, and returns the data without re-locking. **/
+static void* fifoParkLocked(fifo_buffer_t* buffer) 
+{
+    fifo_waiter_t waiter;
+    waiter.next = NULL;
+    waiter.data = NULL;
+    atomic_init(&waiter.filled, 0);
+
+    if (buffer->waiters_tail != NULL) buffer->waiters_tail->next = &waiter;
+    else buffer->waiters_head = &waiter;
+    buffer->waiters_tail = &waiter;
+    fifoLockRelease(&buffer->lock);
+
+    while (atomic_load_explicit(&waiter.filled, memory_order_acquire) == 0) fifoFutexWait(&waiter.filled, 0);
+    return waiter.data;
+}
+
+/////////////////////////////// Flat combining
+// Each in-flight operation is published in a slot. Whichever thread gets the lock becomes the
+// combiner and applies every pending slot in one pass: pushes are merged into the list with a
+// single walk, pulls take from the tail. Nodes are allocated and freed by the publishing
+// threads, outside the lock. Combined operations never wait for room or data; a blocking
+// caller whose combined operation fails falls back to the regular locked path.
+
+enum { FC_FREE, FC_CLAIMED, FC_PENDING, FC_DONE };
+enum { FC_PUSH, FC_PULL };
+
+typedef struct Publication {
+    atomic_int state;
+    int op;
+    bool from_head;         //pull: take the newest node, see fifoPullsFromHead
+    fifo_node_t* node;      //push: node to link, reset to NULL once linked; pull: node unlinked by the combiner
+    int result;             //0 on success, -1 if the buffer was full (push) or empty (pull)
+} __attribute__((aligned(64))) fifo_publication_t;
+
+typedef struct Combiner {
+    fifo_publication_t slots[FIFO_FC_SLOTS];
+} fifo_combiner_t;
+
+static __thread unsigned fc_hint; //per-thread starting slot so threads tend to reuse distinct slots
+
+static void fifoCombinePass(fifo_buffer_t* buffer) 
+{
+    fifo_combiner_t* fc = buffer->combiner;
+    fifo_publication_t* pushes[FIFO_FC_SLOTS];
+    fifo_publication_t* pulls[FIFO_FC_SLOTS];
+    fifo_node_t* nodes[FIFO_FC_SLOTS];
+    fifo_node_t* tmp[FIFO_FC_SLOTS];
+    int num_pushes = 0, num_pulls = 0;
+
+    for (int i = 0; i < FIFO_FC_SLOTS; i++) 
+    {
+        fifo_publication_t* pub = &fc->slots[i];
+        if (atomic_load_explicit(&pub->state, memory_order_acquire) != FC_PENDING) continue;
+        if (pub->op == FC_PUSH) pushes[num_pushes++] = pub;
+        else pulls[num_pulls++] = pub;
+    }
+    if (num_pushes + num_pulls == 0) return;
+
+    if (buffer->signal_ring != NULL) fifoSignalDrainLocked(buffer);
+    int occupancy_before = buffer->buffer_occupancy;
+    int done = 0;
+
+    //Parked consumers take the first pushes directly. The publisher frees the unused node
+    fifo_waiter_t* waiter;
+    while (done < num_pushes && (waiter = fifoHandoffLocked(buffer, pushes[done]->node->data)) != NULL) 
+    {
+        pushes[done++]->result = 0;
+        fifoWaiterWake(waiter);
+    }
+    int handed_off = done;
+
+    //Pushes that fit now, then pulls, then pushes that fit in the room the pulls freed
+    for (int round = 0; round < 2; round++) 
+    {
+        int room = buffer->max_buffer_size - buffer->buffer_occupancy;
+        int n = 0;
+        while (done < num_pushes && n < room) 
+        {
+            nodes[n++] = pushes[done]->node;
+            pushes[done++]->node = NULL; //linked into the list; the publisher must not free it
+        }
+        fifoMergeLocked(buffer, nodes, tmp, n);
+
+        if (round == 0) 
+        {
+            for (int i = 0; i < num_pulls; i++) 
+            {
+                if (buffer->buffer_occupancy > 0) 
+                {
+                    pulls[i]->node = fifoRemoveLocked(buffer, pulls[i]->from_head);
+                    pulls[i]->result = 0;
+                }
+                else pulls[i]->result = -1;
+            }
+        }
+    }
+    
+    for (int i = handed_off; i < num_pushes; i++) 
+    {
+        pushes[i]->result = i < done ? 0 : -1;
+#if FIFO_ENABLE_STATS
+        if (i >= done) buffer->stats.push_rejects++;
+#endif
+    }
+
+    //Wake blocked threads for whatever changed
+    int linked = done - handed_off;
+    if (linked > 0) 
+    {
+        if (linked > 1) fifoCondBroadcast(&buffer->cond_nonempty);
+        else fifoCondSignal(&buffer->cond_nonempty);
+    }
+    if (buffer->buffer_occupancy < occupancy_before + linked) fifoCondBroadcast(&buffer->cond_nonfull);
+
+    for (int i = 0; i < num_pushes; i++) atomic_store_explicit(&pushes[i]->state, FC_DONE, memory_order_release);
+    for (int i = 0; i < num_pulls; i++) atomic_store_explicit(&pulls[i]->state, FC_DONE, memory_order_release);
+}
+
+/**Runs op through the combining slots. Returns false if no slot was free and the caller
+ * must use the regular path. Otherwise *node and *result hold the outcome. **/
+static bool fifoCombine(fifo_buffer_t* buffer, int op, fifo_node_t** node, int* result) 
+{
+    fifo_combiner_t* fc = buffer->combiner;
+    fifo_publication_t* pub = NULL;
+
+    if (fc_hint == 0) fc_hint = (unsigned) (((uintptr_t) &fc_hint >> 6) * 2654435761u) | 1;
+    for (int i = 0; i < FIFO_FC_SLOTS && pub == NULL; i++) 
+    {
+        fifo_publication_t* slot = &fc->slots[(fc_hint + i) % FIFO_FC_SLOTS];
+        int expected = FC_FREE;
+        if (atomic_compare_exchange_strong_explicit(&slot->state, &expected, FC_CLAIMED, memory_order_acquire, memory_order_relaxed)) pub = slot;
+    }
+    if (pub == NULL) return false;
+
+    pub->op = op;
+    pub->from_head = op == FC_PULL && fifoPullsFromHead(buffer);
+    pub->node = *node;
+    atomic_store_explicit(&pub->state, FC_PENDING, memory_order_release);
+
+    for (int spins = 0; atomic_load_explicit(&pub->state, memory_order_acquire) != FC_DONE; spins++) 
+    {
+        if (fifoLockTryAcquire(&buffer->lock) == 0) 
+        {
+            fifoCombinePass(buffer);
+            fifoLockRelease(&buffer->lock);
+        } //became the combiner; our own slot is served in this pass
+        else if (spins > FIFO_FC_SLOTS) sched_yield();
+    }
+
+    *node = pub->node;
+    *result = pub->result;
+    atomic_store_explicit(&pub->state, FC_FREE, memory_order_release);
+    return true;
+}
+
+void fifoAttrInit(fifo_attr_t* attr) 
+{
+    attr->backend = FIFO_BACKEND;
+    attr->lock_kind = FIFO_MUTEX_KIND;
+    attr->combining = false;
+    attr->handoff = FIFO_ENABLE_HANDOFF;
+    attr->mq_threads = 0;
+    attr->lazy_threshold = 0;
+    attr->pull_order = FIFO_ORDER_FIFO;
+    attr->realtime = false;
+    attr->signal_ring = 0;
+    attr->signal_eventfd = false;
+    attr->dedup = FIFO_DEDUP_OFF;
+    attr->dedup_merge = NULL;
+    attr->dedup_filter_counters = 0;
+}
+
+fifo_buffer_t* fifoBufferInit(int max_buffer_size, const char* name) 
+{
+    return fifoBufferInitAttr(max_buffer_size, name, NULL);
+}
+
+fifo_buffer_t* fifoBufferInitAttr(int max_buffer_size, const char* name, const fifo_attr_t* attr) 
+{
+    fifo_attr_t defaults;
+    if (attr == NULL) 
+    {
+        fifoAttrInit(&defaults);
+        attr = &defaults;
+    }
+
+    fifo_attr_t realtime;
+    if (attr->realtime && attr->backend == FIFO_BACKEND_LIST) 
+    {
+        realtime = *attr;
+        realtime.lock_kind = FIFO_LOCK_PI;
+        realtime.combining = false;
+        realtime.lazy_threshold = 0;
+        realtime.pull_order = FIFO_ORDER_FIFO;
+        attr = &realtime;
+    } //features that allocate or walk the list are off in real-time mode
+
+    fifo_attr_t unsynchronized;
+    if (attr->lock_kind == FIFO_LOCK_NONE) 
+    {
+        unsynchronized = *attr;
+        unsynchronized.combining = false;
+        unsynchronized.handoff = false;
+        attr = &unsynchronized;
+    } //both need a second thread to make progress
+
+    bool rt_mode = attr->realtime && attr->backend == FIFO_BACKEND_LIST;
+    fifo_buffer_t *buffer = (fifo_buffer_t*) (rt_mode ? fifoRtAlloc(sizeof(fifo_buffer_t)) : malloc(sizeof(fifo_buffer_t)));
     
-    pthread_mutexattr_t mutex_attr;
-    pthread_mutexattr_init(&mutex_attr);
-    pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_ERRORCHECK);
-    pthread_mutex_init(&buffer->lock,&mutex_attr);
-    pthread_cond_init(&buffer->cond_nonfull,NULL);
-    pthread_cond_init(&buffer->cond_nonempty,NULL);
+    if (fifoLockInit(&buffer->lock, attr->lock_kind) != 0) 
+    {
+        free(buffer);
+        return NULL;
+    }
+    fifoCondInit(&buffer->cond_nonfull);
+    fifoCondInit(&buffer->cond_nonempty);
     buffer->max_buffer_size = max_buffer_size;
     buffer->buffer_occupancy = 0;
-    buffer->sentinel = fifoNodeCreate(NULL,0);
+    buffer->sentinel = rt_mode ? (fifo_node_t*) fifoRtAlloc(sizeof(fifo_node_t)) : fifoNodeCreate(NULL,0);
     buffer->sentinel->next = buffer->sentinel;
     buffer->sentinel->prev = buffer->sentinel;
+    buffer->backend = attr->backend;
+    bool impl_ok = true;
+    switch (buffer->backend) 
+    {
+        case FIFO_BACKEND_FAA:
+            impl_ok = (buffer->impl.faa = fifoFaaCreate()) != NULL;
+            break;
+        case FIFO_BACKEND_MULTIQUEUE:
+            impl_ok = (buffer->impl.mq = fifoMqCreate(attr->mq_threads)) != NULL;
+            break;
+        case FIFO_BACKEND_SKIPLIST:
+            impl_ok = (buffer->impl.skip = fifoSkipCreate()) != NULL;
+            break;
+        case FIFO_BACKEND_RADIX:
+            impl_ok = (buffer->impl.radix = fifoRadixCreate()) != NULL;
+            break;
+        case FIFO_BACKEND_CALENDAR:
+            impl_ok = (buffer->impl.cal = fifoCalCreate()) != NULL;
+            break;
+        case FIFO_BACKEND_STACK:
+            impl_ok = (buffer->impl.stack = fifoStackCreate()) != NULL;
+            break;
+        default:
+            buffer->impl.faa = NULL;
+            break;
+    }
+    if (buffer->backend == FIFO_BACKEND_LIST || buffer->backend == FIFO_BACKEND_RADIX || buffer->backend == FIFO_BACKEND_CALENDAR) 
+    {
+        fifoCondBind(&buffer->cond_nonfull, &buffer->lock);
+        fifoCondBind(&buffer->cond_nonempty, &buffer->lock);
+    } //the lock-free backends wait on the conditions without any lock
+    if (!impl_ok) 
+    {
+        fifoLockDestroy(&buffer->lock);
+        free(buffer->sentinel);
+        free(buffer);
+        return NULL;
+    }
+
+    buffer->pull_order = buffer->backend == FIFO_BACKEND_LIST ? attr->pull_order : FIFO_ORDER_FIFO;
+    buffer->has_owner = false;
+    buffer->lanes = NULL;
+
+    buffer->rt = NULL;
+    if (rt_mode) 
+    {
+        buffer->rt = fifoRtCreate(buffer, max_buffer_size);
+        if (buffer->rt == NULL) 
+        {
+            fifoLockDestroy(&buffer->lock);
+            free(buffer->sentinel);
+            free(buffer);
+            return NULL;
+        }
+    }
+
+    buffer->staging = NULL;
+    buffer->staging_count = 0;
+    buffer->lazy_threshold = 0;
+    if (buffer->backend == FIFO_BACKEND_LIST && buffer->pull_order == FIFO_ORDER_FIFO && attr->lazy_threshold > 0) 
+    {
+        buffer->lazy_threshold = attr->lazy_threshold;
+        buffer->staging = (fifo_node_t**) malloc(2 * attr->lazy_threshold * sizeof(fifo_node_t*)); //second half is sort scratch
+        if (buffer->staging == NULL) 
+        {
+            fifoLockDestroy(&buffer->lock);
+            free(buffer->sentinel);
+            free(buffer);
+            return NULL;
+        }
+    }
+
+    buffer->handoff = attr->handoff;
+    buffer->signal_ring = NULL;
+    if (attr->signal_ring > 0 && buffer->backend == FIFO_BACKEND_LIST) 
+    {
+        buffer->signal_ring = fifoSignalRingCreate(attr->signal_ring, attr->signal_eventfd);
+        if (buffer->signal_ring == NULL) 
+        {
+            if (buffer->rt != NULL) fifoRtDestroy(buffer, max_buffer_size);
+            fifoLockDestroy(&buffer->lock);
+            free(buffer->sentinel);
+            free(buffer->staging);
+            free(buffer);
+            return NULL;
+        }
+        buffer->handoff = false; //a signal handler cannot take the lock to hand data to a parked consumer
+    }
+    buffer->waiters_head = NULL;
+    buffer->waiters_tail = NULL;
+
+    buffer->dedup = NULL;
+    if (attr->dedup != FIFO_DEDUP_OFF && buffer->backend == FIFO_BACKEND_LIST) 
+    {
+        buffer->dedup = fifoDedupCreate(attr, max_buffer_size);
+        if (buffer->dedup == NULL) 
+        {
+            if (buffer->signal_ring != NULL) fifoSignalRingDestroy(buffer->signal_ring);
+            if (buffer->rt != NULL) fifoRtDestroy(buffer, max_buffer_size);
+            fifoLockDestroy(&buffer->lock);
+            free(buffer->sentinel);
+            free(buffer->staging);
+            free(buffer);
+            return NULL;
+        }
+    }
+
+    buffer->combiner = NULL;
+    if (attr->combining) 
+    {
+        if (posix_memalign((void**) &buffer->combiner, 64, sizeof(fifo_combiner_t)) != 0) 
+        {
+            if (buffer->dedup != NULL) fifoDedupDestroy(buffer->dedup);
+            if (buffer->signal_ring != NULL) fifoSignalRingDestroy(buffer->signal_ring);
+            fifoLockDestroy(&buffer->lock);
+            free(buffer->sentinel);
+            free(buffer->staging);
+            free(buffer);
+            return NULL;
+        }
+        for (int i = 0; i < FIFO_FC_SLOTS; i++) atomic_init(&buffer->combiner->slots[i].state, FC_FREE);
+    }
+    memset(&buffer->stats, 0, sizeof(buffer->stats));
+    
+    buffer->name[0] = '\0';
+    buffer->registry_slot = -1;
+    if (name != NULL) 
+    {
+        strncpy(buffer->name, name, FIFO_NAME_MAX - 1);
+        buffer->name[FIFO_NAME_MAX - 1] = '\0';
+        if (attr->lock_kind != FIFO_LOCK_NONE) buffer->registry_slot = fifoRegistryAdd(buffer); //publish last so dumps never see a partial buffer
+    }
     return buffer;
 }
 
+void fifoBufferSetOwner(fifo_buffer_t* buffer) 
+{
+    fifoLockAcquire(&buffer->lock);
+    buffer->owner = pthread_self();
+    buffer->has_owner = true;
+    fifoLockRelease(&buffer->lock);
+}
+
 /**Closes all references to the buffer, returning the data 
  * conents remaining in a NULL-terminated array of pointers**/
 void** fifoBufferClose(fifo_buffer_t* buffer) 
 {
     
+    fifoRegistryRemove(buffer); //unpublish first so no dump can reach the buffer once it is freed
     void* *out = fifoFlush(buffer,true);
-    pthread_mutex_destroy(&buffer->lock);
-    pthread_cond_destroy(&buffer->cond_nonempty); 
-    pthread_cond_destroy(&buffer->cond_nonfull);
+    switch (buffer->backend) 
+    {
+        case FIFO_BACKEND_FAA: fifoFaaDestroy(buffer->impl.faa); break;
+        case FIFO_BACKEND_MULTIQUEUE: fifoMqDestroy(buffer->impl.mq); break;
+        case FIFO_BACKEND_SKIPLIST: fifoSkipDestroy(buffer->impl.skip); break;
+        case FIFO_BACKEND_RADIX: fifoRadixDestroy(buffer->impl.radix); break;
+        case FIFO_BACKEND_CALENDAR: fifoCalDestroy(buffer->impl.cal); break;
+        case FIFO_BACKEND_STACK: fifoStackDestroy(buffer->impl.stack); break;
+        default: break;
+    }
+    if (buffer->rt != NULL) fifoRtDestroy(buffer, buffer->max_buffer_size);
+    free(buffer->sentinel);
+    free(buffer->combiner);
+    free(buffer->staging);
+    if (buffer->signal_ring != NULL) fifoSignalRingDestroy(buffer->signal_ring);
+    if (buffer->dedup != NULL) fifoDedupDestroy(buffer->dedup);
+    while (buffer->lanes != NULL) 
+    {
+        fifo_lane_t* next = buffer->lanes->next;
+        free(buffer->lanes);
+        buffer->lanes = next;
+    }
+    fifoLockDestroy(&buffer->lock);
     free(buffer);
 
     return out; 
@@ -91,11 +879,11 @@ int fifoLockBuffer(fifo_buffer_t* buffer, bool blocking)
 {
     if (blocking) 
     {
-        return pthread_mutex_lock(&buffer->lock);
+        return fifoLockAcquire(&buffer->lock);
     }
     else 
     {
-        return pthread_mutex_trylock(&buffer->lock);
+        return fifoLockTryAcquire(&buffer->lock);
     }
 }
 
@@ -106,54 +894,219 @@ int fifoLockBuffer(fifo_buffer_t* buffer, bool blocking)
  * first node of equal or greater priority.  **/
 int fifoPush(fifo_buffer_t* buffer, void* data, int priority, bool blocking) 
 {
+    switch (buffer->backend) 
+    {
+        case FIFO_BACKEND_FAA: return fifoFaaPush(buffer, data); //lock-free, never full
+        case FIFO_BACKEND_MULTIQUEUE: return fifoMqPush(buffer, data, priority, blocking);
+        case FIFO_BACKEND_SKIPLIST: return fifoSkipPush(buffer, data, priority, blocking);
+        case FIFO_BACKEND_RADIX: return fifoRadixPush(buffer, data, (uint64_t) priority, priority < 0, blocking);
+        case FIFO_BACKEND_CALENDAR: return fifoCalPush(buffer, data, (uint64_t) priority, priority < 0, blocking);
+        case FIFO_BACKEND_STACK: return fifoStackPush(buffer, data, blocking);
+        default: break;
+    } //backends with their own synchronization
+    if (buffer->combiner != NULL) 
+    {
+        fifo_node_t* node = fifoNodeCreate(data, priority);
+        int result;
+        if (fifoCombine(buffer, FC_PUSH, &node, &result)) 
+        {
+            if (result == 0) 
+            {
+                if (node != NULL) fifoNodeDestroy(node); //handed off to a parked consumer instead of linked
+                return 0;
+            }
+            if (!blocking) 
+            {
+                fifoNodeDestroy(node);
+                return -1;
+            }
+        } //combined push failed only if the buffer was full; blocking callers wait below
+        fifoNodeDestroy(node);
+    }
 
     int lock_status = fifoLockBuffer(buffer,blocking);
 
     //Push node into buffer if mutex acquired ///////////////////////
     if (lock_status == 0) 
     {
-        if(buffer->buffer_occupancy >= buffer->max_buffer_size) 
+        while(buffer->buffer_occupancy >= buffer->max_buffer_size) 
         {
             if (blocking) 
             {
                 int cond_status;
-                cond_status = pthread_cond_wait(&buffer->cond_nonfull, &buffer->lock);
+                unsigned seq = fifoCondPrepare(&buffer->cond_nonfull);
+                cond_status = fifoCondWait(&buffer->cond_nonfull, &buffer->lock, seq);
                 if (cond_status != 0) return cond_status; 
-            } //if blocking set, wait until nonfull signal is emitted
+            } //if blocking set, wait until nonfull signal is emitted. Loop guards against spurious wake-ups
             else 
             {
-                pthread_mutex_unlock(&buffer->lock);
+#if FIFO_ENABLE_STATS
+                buffer->stats.push_rejects++;
+#endif
+                fifoLockRelease(&buffer->lock);
                 return -1;
             } //otw return immediately with -1;
         } //If buffer full, wait or return
 
         //This point reached only if mutex is obtained and nonfull signal has been emitted
-        fifo_node_t* new_node = fifoNodeCreate(data, priority); //initialize new buffer node
+        fifo_waiter_t* waiter = fifoHandoffLocked(buffer, data);
+        if (waiter != NULL) 
+        {
+            fifoLockRelease(&buffer->lock);
+            fifoWaiterWake(waiter);
+            return 0;
+        } //a consumer is parked on the empty buffer: give it the data, no node needed
+
+        if (buffer->staging != NULL) fifoStageLocked(buffer, fifoNodeCreate(data, priority)); //lazy mode: O(1) append
+        else if (buffer->rt != NULL) fifoInsertLocked(buffer, fifoRtNodeGetLocked(buffer, data, priority)); //real-time: pooled node
+        else fifoInsertLocked(buffer, fifoNodeCreate(data, priority)); //initialize new buffer node and link it
+
+        fifoCondSignal(&buffer->cond_nonempty);
+        fifoLockRelease(&buffer->lock);
+    } // continue if lock successfully obtained
+    ///////////////////////////////////////////////////////////
+
+    return lock_status;
+}   
+
+/**Push data with a 64-bit key into a keyed backend; see fifo_radix.c and fifo_calendar.c **/
+int fifoPushKey(fifo_buffer_t* buffer, void* data, uint64_t key, bool blocking) 
+{
+    switch (buffer->backend) 
+    {
+        case FIFO_BACKEND_RADIX: return fifoRadixPush(buffer, data, key, false, blocking);
+        case FIFO_BACKEND_CALENDAR: return fifoCalPush(buffer, data, key, false, blocking);
+        default: return EINVAL;
+    }
+}
+
+/**Push data unless an item with the same key is still queued; see fifo_attr_t.dedup **/
+int fifoPushUnique(fifo_buffer_t* buffer, void* data, int priority, uint64_t key, bool blocking) 
+{
+    if (buffer->dedup == NULL) return ENOTSUP;
 
-        if (priority < 0) 
+    int lock_status = fifoLockBuffer(buffer,blocking);
+    if (lock_status != 0) return lock_status;
+
+    for (;;) 
+    {
+        fifo_node_t* queued;
+        if (fifoDedupFind(buffer->dedup, key, &queued)) 
         {
-            addNodeAfter(buffer->sentinel->prev,new_node);
-        } //Negative priorities are considered higher than any existing. Append to tail
-        else 
+            fifoDedupMerge(buffer->dedup, queued, data);
+#if FIFO_ENABLE_STATS
+            buffer->stats.duplicates++;
+#endif
+            fifoLockRelease(&buffer->lock);
+            return EEXIST;
+        } //a duplicate never waits for room
+        if (buffer->buffer_occupancy < buffer->max_buffer_size) break;
+
+        if (!blocking) 
         {
-            //loop through buffer until a node of equal or higher priority is found.
-            fifo_node_t* p;
-            for (p = buffer->sentinel->next; p != buffer->sentinel;p = p->next) 
+#if FIFO_ENABLE_STATS
+            buffer->stats.push_rejects++;
+#endif
+            fifoLockRelease(&buffer->lock);
+            return -1;
+        }
+        unsigned seq = fifoCondPrepare(&buffer->cond_nonfull);
+        int cond_status = fifoCondWait(&buffer->cond_nonfull, &buffer->lock, seq);
+        if (cond_status != 0) return cond_status;
+    } //key rechecked after every wait: another push may have queued it meanwhile
+
+    fifo_waiter_t* waiter = fifoHandoffLocked(buffer, data);
+    if (waiter != NULL) 
+    {
+        fifoLockRelease(&buffer->lock);
+        fifoWaiterWake(waiter);
+        return 0;
+    } //consumed on the spot, so the key is never queued
+
+    fifo_node_t* node = buffer->rt != NULL ? fifoRtNodeGetLocked(buffer, data, priority) : fifoNodeCreate(data, priority);
+    node->keyed = true;
+    node->key = key;
+    fifoDedupInsert(buffer->dedup, key, node);
+    if (buffer->staging != NULL) fifoStageLocked(buffer, node);
+    else fifoInsertLocked(buffer, node);
+
+    fifoCondSignal(&buffer->cond_nonempty);
+    fifoLockRelease(&buffer->lock);
+    return 0;
+}
+
+/**Push count data pointers with their priorities (NULL priorities means all 0) as one
+ * operation. The result is identical to count calls of fifoPush in array order, but the
+ * list is walked once and the lock taken once: the batch is stably sorted by priority and
+ * merged in O(n + k log k). The batch is accepted whole or not at all: if blocking == true
+ * this waits until there is room for every item, otherwise -1 is returned when there is not.
+ * A batch larger than the buffer capacity is always refused with -1. **/
+int fifoPushBatch(fifo_buffer_t* buffer, void** data, const int* priorities, int count, bool blocking) 
+{
+    if (count <= 0) return 0;
+    if (count > buffer->max_buffer_size && buffer->backend != FIFO_BACKEND_FAA) return -1; //FAA ignores the capacity
+
+    if (buffer->backend != FIFO_BACKEND_LIST || buffer->rt != NULL) 
+    {
+        for (int i = 0; i < count; i++) 
+        {
+            int status = fifoPush(buffer, data[i], priorities != NULL ? priorities[i] : 0, blocking);
+            if (status != 0) return status;
+        }
+        return 0;
+    } //other backends have no ordered list to merge into, and real-time mode must not allocate; not all-or-nothing there
+
+    //Allocate outside the lock: one array holds the nodes, the second half is sort scratch
+    fifo_node_t** nodes = (fifo_node_t**) malloc(2 * count * sizeof(fifo_node_t*));
+    if (nodes == NULL) return ENOMEM;
+    for (int i = 0; i < count; i++) nodes[i] = fifoNodeCreate(data[i], priorities != NULL ? priorities[i] : 0);
+
+    int lock_status = fifoLockBuffer(buffer,blocking);
+    if (lock_status == 0) 
+    {
+        while(buffer->buffer_occupancy + count > buffer->max_buffer_size) 
+        {
+            int cond_status = 0;
+            if (blocking) 
             {
-                if (p->priority >= new_node->priority || p->priority < 0) break;
+                unsigned seq = fifoCondPrepare(&buffer->cond_nonfull);
+                cond_status = fifoCondWait(&buffer->cond_nonfull, &buffer->lock, seq);
+            } //wait for room for the whole batch
+            if (!blocking || cond_status != 0) 
+            {
+#if FIFO_ENABLE_STATS
+                if (!blocking) buffer->stats.push_rejects++;
+#endif
+                if (cond_status == 0) fifoLockRelease(&buffer->lock);
+                for (int i = 0; i < count; i++) fifoNodeDestroy(nodes[i]);
+                free(nodes);
+                return blocking ? cond_status : -1;
             }
-            addNodeAfter(p->prev,new_node);
-        } //For non-negative priorities, find node of equal or greater priority. Insert new node before.
+        }
 
-        buffer->buffer_occupancy++;
+        //Consumers parked on the empty buffer take the leading items, exactly as sequential pushes would
+        fifo_waiter_t* waiter;
+        int handed_off = 0;
+        while (handed_off < count && (waiter = fifoHandoffLocked(buffer, nodes[handed_off]->data)) != NULL) 
+        {
+            fifoWaiterWake(waiter);
+            handed_off++;
+        }
 
-        pthread_cond_signal(&buffer->cond_nonempty);
-        pthread_mutex_unlock(&buffer->lock);
-    } // continue if lock successfully obtained
-    ///////////////////////////////////////////////////////////
+        int linked = count - handed_off;
+        fifoMergeLocked(buffer, nodes + handed_off, nodes + count, linked);
 
+        if (linked > 1) fifoCondBroadcast(&buffer->cond_nonempty);
+        else if (linked == 1) fifoCondSignal(&buffer->cond_nonempty);
+        fifoLockRelease(&buffer->lock);
+
+        for (int i = 0; i < handed_off; i++) free(nodes[i]); //unused: data went straight to a consumer
+    }
+    else for (int i = 0; i < count; i++) fifoNodeDestroy(nodes[i]);
+
+    free(nodes);
     return lock_status;
-}   
+}
 
 void* fifoPull(fifo_buffer_t* buffer, bool blocking) 
 {
@@ -162,38 +1115,116 @@ void* fifoPull(fifo_buffer_t* buffer, bool blocking)
      * available and non-empty. A non-null pointer is returned if the 
      * pull was successful.   **/
 
+    switch (buffer->backend) 
+    {
+        case FIFO_BACKEND_FAA: return fifoFaaPull(buffer, blocking);
+        case FIFO_BACKEND_MULTIQUEUE: return fifoMqPull(buffer, blocking);
+        case FIFO_BACKEND_SKIPLIST: return fifoSkipPull(buffer, blocking);
+        case FIFO_BACKEND_RADIX: return fifoRadixPull(buffer, blocking);
+        case FIFO_BACKEND_CALENDAR: return fifoCalPull(buffer, blocking);
+        case FIFO_BACKEND_STACK: return fifoStackPull(buffer, blocking);
+        default: break;
+    } //backends with their own synchronization
+
+    if (buffer->combiner != NULL) 
+    {
+        fifo_node_t* node = NULL;
+        int result;
+        if (fifoCombine(buffer, FC_PULL, &node, &result)) 
+        {
+            if (result == 0) return fifoNodeDestroy(node);
+            if (!blocking) return NULL;
+        } //combined pull failed only if the buffer was empty; blocking callers wait below
+    }
+
     int lock_status = fifoLockBuffer(buffer,blocking);
 
     if (lock_status == 0)
     {
-        if(buffer->buffer_occupancy <= 0) 
+        if (buffer->signal_ring != NULL) fifoSignalDrainLocked(buffer);
+        while(buffer->buffer_occupancy <= 0) 
         {
-            if (blocking) 
+            if (blocking && buffer->handoff) 
+            {
+                return fifoParkLocked(buffer);
+            } //park until a producer hands data over directly
+            else if (blocking) 
             {
                 int cond_status;
-                cond_status = pthread_cond_wait(&buffer->cond_nonempty, &buffer->lock); 
+                unsigned seq = fifoCondPrepare(&buffer->cond_nonempty);
+                if (buffer->signal_ring != NULL) 
+                {
+                    fifoSignalDrainLocked(buffer);
+                    if (buffer->buffer_occupancy > 0) break;
+                } //ring checked after the snapshot, so a signal-safe push in between still wakes us
+                cond_status = fifoCondWait(&buffer->cond_nonempty, &buffer->lock, seq); 
                 if (cond_status != 0) return NULL;
-            } //if blocking set, wait until nonempty signal is emitted
+            } //if blocking set, wait until nonempty signal is emitted. Loop guards against spurious wake-ups
             else 
             {
-                pthread_mutex_unlock(&buffer->lock);
+                fifoLockRelease(&buffer->lock);
                 return NULL;
             } //otw unlock acquired mutex and return with NULL;
         } //If buffer empty, wait or return
 
         //This point is reached if the buffer is available and nonempty
-        fifo_node_t* rec = removeNode(buffer, buffer->sentinel->prev);  //remove node at buffer tail
-        
-        buffer->buffer_occupancy--;
+        fifo_node_t* rec = fifoRemoveLocked(buffer, fifoPullsFromHead(buffer));  //remove node at buffer tail, or head in LIFO order
+        void* data = rec->data;
+        rec = fifoNodeRecycleLocked(buffer, rec);
         
-        pthread_cond_signal(&buffer->cond_nonfull);
-        pthread_mutex_unlock(&buffer->lock);
+        fifoCondSignal(&buffer->cond_nonfull);
+        fifoLockRelease(&buffer->lock);
         
-        return fifoNodeDestroy(rec); //deallocate memory and return data pointer
+        free(rec); //deallocate memory outside the lock; NULL in real-time mode
+        return data;
     } //Pull from buffer if lock acquired 
     else return NULL;
 }
 
+/**Pulls the next item only if it is urgent: its priority is negative or at least threshold.
+ * The list keeps the most urgent item at the tail, so only the tail is examined. If blocking
+ * is set, waits in the lane for threshold until a qualifying item is pushed. **/
+void* fifoPullMinPriority(fifo_buffer_t* buffer, int threshold, bool blocking) 
+{
+#if FIFO_ENABLE_PRIORITY
+    if (buffer->backend != FIFO_BACKEND_LIST || buffer->pull_order != FIFO_ORDER_FIFO || buffer->signal_ring != NULL || buffer->rt != NULL) 
+#endif
+    {
+        errno = ENOTSUP;
+        return NULL;
+    } //needs the priority-ordered list; signal-safe pushes cannot reach the lanes, and a
+      //real-time push must not walk an unbounded lane list
+
+    int lock_status = fifoLockBuffer(buffer,blocking);
+    if (lock_status != 0) return NULL;
+
+    fifo_lane_t* lane = NULL;
+    for (;;) 
+    {
+        fifoStagingMergeLocked(buffer);
+        fifo_node_t* tail = buffer->sentinel->prev;
+        if (tail != buffer->sentinel && (tail->priority < 0 || tail->priority >= threshold)) break;
+
+        if (blocking && lane == NULL) lane = fifoLaneGetLocked(buffer, threshold);
+        if (lane == NULL) 
+        {
+            fifoLockRelease(&buffer->lock);
+            if (blocking) errno = ENOMEM;
+            return NULL;
+        } //non-blocking, or no memory for the lane
+        unsigned seq = fifoCondPrepare(&lane->cond);
+        if (fifoCondWait(&lane->cond, &buffer->lock, seq) != 0) return NULL;
+    } //loop guards against spurious wake-ups and against ordinary consumers taking the item first
+
+    fifo_node_t* rec = fifoRemoveLocked(buffer, false);
+    void* data = rec->data;
+    rec = fifoNodeRecycleLocked(buffer, rec);
+    fifoCondSignal(&buffer->cond_nonfull);
+    fifoLockRelease(&buffer->lock);
+    free(rec);
+    return data;
+}
+
 void** fifoFlush(fifo_buffer_t* buffer, bool blocking) 
 {
     /**Empties the buffer, returning a NULL-terminated 
@@ -204,23 +1235,53 @@ void** fifoFlush(fifo_buffer_t* buffer, bool blocking)
      * NULL terminated array containing the remaining buffer 
      * contents is returned 
      */
+    switch (buffer->backend) 
+    {
+        case FIFO_BACKEND_FAA: return fifoFaaFlush(buffer); //not atomic with respect to concurrent pushes
+        case FIFO_BACKEND_MULTIQUEUE: return fifoMqFlush(buffer);
+        case FIFO_BACKEND_SKIPLIST: return fifoSkipFlush(buffer); //not atomic with respect to concurrent pushes
+        case FIFO_BACKEND_RADIX: return fifoRadixFlush(buffer, blocking);
+        case FIFO_BACKEND_CALENDAR: return fifoCalFlush(buffer, blocking);
+        case FIFO_BACKEND_STACK: return fifoStackFlush(buffer); //not atomic with respect to concurrent pushes
+        default: break;
+    } //backends with their own synchronization
+
     int lock_status = fifoLockBuffer(buffer,blocking);
     
     if (lock_status == 0) //if mutex obtained
     {
+        if (buffer->signal_ring != NULL) fifoSignalDrainLocked(buffer);
+        fifoStagingMergeLocked(buffer);
+        int overflow = buffer->signal_ring != NULL ? fifoSignalRingCount(buffer->signal_ring) : 0;
+
         //allocate output array of nodes. +1 for NULL terminator
-        void** out = (void*) calloc(buffer->buffer_occupancy + 1,sizeof(void*));
+        void** out = (void*) calloc(buffer->buffer_occupancy + overflow + 1,sizeof(void*));
 
-        //iterate over current FIFO nodes
+        //iterate over current FIFO nodes, from the end this thread would pull from
         int i = 0;
+        bool from_head = fifoPullsFromHead(buffer);
         while (buffer->sentinel->prev != buffer->sentinel) 
         {
             //NOTE: fifoPull is not used here because that function requires access to the mutex
             //      Using here would cause a deadlock. Direct list manipulation is done to make
             //      fifoFlush an atomic operation.
-            out[i] = fifoNodeDestroy(removeNode(buffer,buffer->sentinel->prev));
+            fifo_node_t* rec = removeNode(buffer,from_head ? buffer->sentinel->next : buffer->sentinel->prev);
+            out[i] = rec->data;
+            free(fifoNodeRecycleLocked(buffer, rec));
             i++;
         }
+#if FIFO_ENABLE_STATS
+        int removed = i; //ring overflow below never entered the buffer, so it is not a pull
+#endif
+        if (buffer->dedup != NULL) fifoDedupClear(buffer->dedup);
+        int priority;
+        while (overflow-- > 0 && fifoSignalRingPop(buffer->signal_ring, &out[i], &priority)) i++; //did not fit in the buffer; arrival order
+        if (buffer->rt != NULL) 
+        {
+            buffer->rt->levels_used = 0;
+            buffer->rt->negative_head = NULL;
+            memset(buffer->rt->level_head, 0, sizeof(buffer->rt->level_head));
+        }
         
         out[i] = NULL; //Append NULL termination
         
@@ -228,24 +1289,164 @@ void** fifoFlush(fifo_buffer_t* buffer, bool blocking)
         buffer->sentinel->prev = buffer->sentinel;
         buffer->sentinel->next = buffer->sentinel;
         buffer->buffer_occupancy = 0;
+#if FIFO_ENABLE_STATS
+        buffer->stats.pulls += removed;
+#endif
         
-        pthread_cond_signal(&buffer->cond_nonfull);
-        pthread_mutex_unlock(&buffer->lock);
+        fifoCondSignal(&buffer->cond_nonfull);
+        fifoLockRelease(&buffer->lock);
         return out;
     } //end if (lock_status == 0) i.e. if mutex obtained
     else return NULL; //if failed to obtain mutex, return NULL
 }
 
-void fifoPrint(fifo_buffer_t* buffer) 
+int fifoGetStats(fifo_buffer_t* buffer, fifo_stats_t* stats_out) 
 {
-    fifo_node_t* p;
-    int i = 0;
+    switch (buffer->backend) 
+    {
+        case FIFO_BACKEND_FAA:
+            memset(stats_out, 0, sizeof(*stats_out));
+            fifoFaaSnapshot(buffer, NULL, 0, &stats_out->occupancy);
+            return 0; //lock-free backend keeps no shared counters; occupancy is counted on demand
+        case FIFO_BACKEND_MULTIQUEUE:
+            fifoMqStats(buffer, stats_out);
+            return 0;
+        case FIFO_BACKEND_SKIPLIST:
+            memset(stats_out, 0, sizeof(*stats_out));
+            fifoSkipSnapshot(buffer, NULL, 0, &stats_out->occupancy);
+            return 0;
+        case FIFO_BACKEND_STACK:
+            memset(stats_out, 0, sizeof(*stats_out));
+            fifoStackSnapshot(buffer, NULL, 0, &stats_out->occupancy);
+            return 0;
+        default: break;
+    }
     
-    for (p = buffer->sentinel->next; p != buffer->sentinel; p = p->next) 
+    int lock_status = fifoLockBuffer(buffer,true);
+    if (lock_status == 0) 
+    {
+        *stats_out = buffer->stats;
+        stats_out->occupancy = buffer->buffer_occupancy;
+        fifoLockRelease(&buffer->lock);
+    }
+    return lock_status;
+}
+
+const char* fifoBackendName(fifo_backend_t backend) 
+{
+    switch (backend) 
+    {
+        case FIFO_BACKEND_LIST: return "list";
+        case FIFO_BACKEND_FAA: return "faa";
+        case FIFO_BACKEND_MULTIQUEUE: return "multiqueue";
+        case FIFO_BACKEND_SKIPLIST: return "skiplist";
+        case FIFO_BACKEND_RADIX: return "radix";
+        case FIFO_BACKEND_CALENDAR: return "calendar";
+        case FIFO_BACKEND_STACK: return "stack";
+        default: return "unknown";
+    }
+}
+
+int fifoSnapshot(fifo_buffer_t* buffer, fifo_snapshot_t* snap, fifo_snapshot_entry_t* entries, int max_entries, bool blocking) 
+{
+    if (buffer->backend != FIFO_BACKEND_LIST && buffer->backend != FIFO_BACKEND_RADIX && buffer->backend != FIFO_BACKEND_CALENDAR) 
+    {
+        fifoGetStats(buffer, &snap->stats);
+        snap->capacity = buffer->max_buffer_size;
+        switch (buffer->backend) 
+        {
+            case FIFO_BACKEND_FAA: snap->count = fifoFaaSnapshot(buffer, entries, max_entries, &snap->stats.occupancy); break;
+            case FIFO_BACKEND_SKIPLIST: snap->count = fifoSkipSnapshot(buffer, entries, max_entries, &snap->stats.occupancy); break;
+            case FIFO_BACKEND_STACK: snap->count = fifoStackSnapshot(buffer, entries, max_entries, &snap->stats.occupancy); break;
+            default: snap->count = fifoMqSnapshot(buffer, entries, max_entries); break;
+        }
+        snap->occupancy = snap->stats.occupancy;
+        snap->taken_ns = fifoNowNs();
+        snap->entries = entries;
+        return 0;
+    } //FAA, SKIPLIST and STACK are walked lock-free; MULTIQUEUE locks one heap at a time, never the whole buffer
+
+    int lock_status = fifoLockBuffer(buffer,blocking);
+    
+    if (lock_status == 0) 
+    {
+        if (buffer->signal_ring != NULL) fifoSignalDrainLocked(buffer);
+        fifoStagingMergeLocked(buffer); //positions are only meaningful in merged order
+
+        //Copy only; formatting happens later in fifoSnapshotFormat so producers are not held up
+        uint64_t now = fifoNowNs();
+        int i = 0;
+        bool from_head = fifoPullsFromHead(buffer);
+        fifo_node_t* p;
+        if (buffer->backend == FIFO_BACKEND_RADIX) i = fifoRadixSnapshotLocked(buffer, entries, max_entries, now);
+        else if (buffer->backend == FIFO_BACKEND_CALENDAR) i = fifoCalSnapshotLocked(buffer, entries, max_entries, now);
+        else for (p = from_head ? buffer->sentinel->next : buffer->sentinel->prev; p != buffer->sentinel && i < max_entries; p = from_head ? p->next : p->prev) 
+        {
+            entries[i].position = i;
+            entries[i].priority = p->priority;
+            entries[i].age_ns = now - p->enqueue_ns;
+            entries[i].data = p->data;
+            i++;
+        } //walk from the pull end so entries are in first-out order
+
+        snap->capacity = buffer->max_buffer_size;
+        snap->occupancy = buffer->buffer_occupancy;
+        snap->stats = buffer->stats;
+        snap->stats.occupancy = buffer->buffer_occupancy;
+        snap->taken_ns = now;
+        snap->count = i;
+        snap->entries = entries;
+        
+        fifoLockRelease(&buffer->lock);
+    }
+
+    return lock_status;
+}
+
+int fifoSnapshotFormat(const fifo_snapshot_t* snap, char* out, size_t out_len) 
+{
+    int total = 0;
+    int n;
+
+    //snprintf with a zero length is used once out is exhausted so the full length is still counted
+    #define FIFO_APPEND(...) \
+        n = snprintf(out + (total < (int) out_len ? total : 0), total < (int) out_len ? out_len - total : 0, __VA_ARGS__); \
+        if (n > 0) total += n;
+
+    FIFO_APPEND("capacity=%d occupancy=%d pushes=%lu pulls=%lu rejects=%lu peak=%d shown=%d\n",
+                snap->capacity, snap->occupancy, snap->stats.pushes, snap->stats.pulls,
+                snap->stats.push_rejects, snap->stats.peak_occupancy, snap->count);
+    for (int i = 0; i < snap->count; i++) 
+    {
+        const fifo_snapshot_entry_t* e = &snap->entries[i];
+        FIFO_APPEND(" Position %d:  Priority=%d  Age=%.3fms  Data=%p\n",
+                    e->position, e->priority, e->age_ns / 1e6, e->data);
+    }
+    #undef FIFO_APPEND
+
+    return total;
+}
+
+void fifoPrint(fifo_buffer_t* buffer) 
+{
+    fifo_snapshot_t snap;
+    int max_entries = buffer->max_buffer_size;
+    fifo_snapshot_entry_t* entries = (fifo_snapshot_entry_t*) malloc(max_entries * sizeof(fifo_snapshot_entry_t));
+    if (entries == NULL || fifoSnapshot(buffer, &snap, entries, max_entries, true) != 0) 
+    {
+        free(entries);
+        return;
+    }
+
+    int len = fifoSnapshotFormat(&snap, NULL, 0);
+    char* text = (char*) malloc(len + 1);
+    if (text != NULL) 
     {
-        printf(" Node %d:  Address=%p  Priority=%d  Next=%p  Prev=%p\n",i,p,p->priority,p->next,p->prev);
-        i++;
+        fifoSnapshotFormat(&snap, text, len + 1);
+        fputs(text, stdout);
+        free(text);
     }
+    free(entries);
 }
 
 int fifoUpdateOccupancy(fifo_buffer_t* buffer) 
@@ -255,6 +1456,7 @@ int fifoUpdateOccupancy(fifo_buffer_t* buffer)
 
     int cnt = 0;
     fifo_node_t* p;
+    fifoStagingMergeLocked(buffer);
     for (p = buffer->sentinel->next; p != buffer->sentinel; p = p->next) cnt++;
     
     buffer->buffer_occupancy = cnt;
@@ -16,7 +16,8 @@
  *  The data member of each node is a void pointer. Data is pushed 
  * 
  * Usage:
- *  1) Instantiate buffer using fifoBufferInit()
+ *  1) Instantiate buffer using fifoBufferInit(). A non-NULL name registers the buffer
+ *     in the global registry so it appears in fifoRegistryDump()
  *  2) Push data into buffer using fifoPush()
  *     a) A new fifo_node_t is allocated and assigned the void* data passed to fifoPull
  *     b) This new node is placed at beginning of list (sentinel->next)
@@ -41,45 +42,267 @@
     #include <stdbool.h>
     #include <stdio.h>
     #include <errno.h>
+    #include <stdint.h>
+    #include "fifo_config.h"
+    #include "fifo_lock.h"
 
     typedef struct Node {
         void* data;
         struct Node *next;
         struct Node *prev;
         int priority;
+        bool keyed;             //pushed by fifoPushUnique; key is in the dedup index
+        uint64_t enqueue_ns;    //CLOCK_MONOTONIC time of the push, used for snapshot ages
+        uint64_t key;
     } fifo_node_t;
 
+    //Maximum length of a buffer name, including the NULL terminator
+    #define FIFO_NAME_MAX 32
+
+    //Storage engine used by a buffer. Reported by fifoRegistryDump
+    typedef enum Backend {
+        FIFO_BACKEND_LIST,  //doubly linked list with sentinel, priority ordered
+        FIFO_BACKEND_FAA,   //unbounded lock-free MPMC queue of fetch-and-add array segments; no priorities, NULL data rejected
+        FIFO_BACKEND_MULTIQUEUE,//relaxed priority order over c x P heaps; scales with threads
+        FIFO_BACKEND_SKIPLIST,  //lock-free skip list; exact priority order, parallel inserts
+        FIFO_BACKEND_RADIX,     //radix heap over monotone 64-bit keys, smallest first; see fifoPushKey
+        FIFO_BACKEND_CALENDAR,  //self-resizing calendar queue over 64-bit event times, smallest first
+        FIFO_BACKEND_STACK      //lock-free Treiber stack; last-in first-out, no priorities
+    } fifo_backend_t;
+
+    //Which end of the list backend fifoPull takes from
+    typedef enum PullOrder {
+        FIFO_ORDER_FIFO,    //oldest first, in priority order (default)
+        FIFO_ORDER_LIFO,    //newest first; priorities are ignored
+        FIFO_ORDER_MIXED    //the owner (fifoBufferSetOwner) pulls newest first, other threads oldest first; priorities are ignored
+    } fifo_pull_order_t;
+
+    //Key index behind fifoPushUnique
+    typedef enum DedupMode {
+        FIFO_DEDUP_OFF,
+        FIFO_DEDUP_EXACT,       //open-addressing hash of the queued keys; exact, supports merging
+        FIFO_DEDUP_FILTER       //counting Bloom filter; fixed small memory, may reject a new key
+    } fifo_dedup_mode_t;
+
+    //Counters maintained under the buffer lock
+    typedef struct Stats {
+        unsigned long pushes;           //successful pushes
+        unsigned long pulls;            //successful pulls (flushed entries included)
+        unsigned long push_rejects;     //non-blocking pushes refused because the buffer was full
+        unsigned long handoffs;         //pushes delivered straight to a parked consumer
+        unsigned long duplicates;       //fifoPushUnique calls that found their key queued
+        int peak_occupancy;             //highest occupancy observed
+        int occupancy;                  //occupancy at the time the stats were copied
+        unsigned long rank_error_sum;       //relaxed backends: sum of sampled rank errors
+        unsigned long rank_error_samples;   //relaxed backends: number of samples in rank_error_sum
+        unsigned long rank_error_max;       //relaxed backends: worst sampled rank error
+    } fifo_stats_t;
+
+    //Per-buffer options for fifoBufferInitAttr. Always initialize with fifoAttrInit first
+    typedef struct Attr {
+        fifo_backend_t backend;         //storage engine, defaults to FIFO_BACKEND
+        fifo_lock_kind_t lock_kind;     //lock strategy, defaults to FIFO_MUTEX_KIND
+        bool combining;                 //flat combining of concurrent push/pull, default false
+        bool handoff;                   //direct hand-off to parked consumers, default FIFO_ENABLE_HANDOFF
+        int mq_threads;                 //FIFO_BACKEND_MULTIQUEUE: expected thread count P, 0 for online CPUs
+        int lazy_threshold;             //FIFO_BACKEND_LIST: >0 enables lazy priority ordering, see fifoPush
+        fifo_pull_order_t pull_order;   //FIFO_BACKEND_LIST: pull end, default FIFO_ORDER_FIFO
+        bool realtime;                  //FIFO_BACKEND_LIST: bounded-time operations, see fifoBufferInitAttr
+        int signal_ring;                //FIFO_BACKEND_LIST: >0 enables fifoPushSignalSafe with a ring of this many slots
+        bool signal_eventfd;            //with signal_ring: also signal an eventfd, see fifoSignalFd
+        fifo_dedup_mode_t dedup;        //FIFO_BACKEND_LIST: key index for fifoPushUnique, default FIFO_DEDUP_OFF
+        void* (*dedup_merge)(void* queued, void* incoming); //FIFO_DEDUP_EXACT: folds a duplicate into the queued item; NULL rejects it
+        int dedup_filter_counters;      //FIFO_DEDUP_FILTER: filter size, 0 for 8 counters per capacity slot
+    } fifo_attr_t;
+
+    //Consumer parked in a blocking fifoPull on an empty buffer. Lives on the consumer's stack
+    typedef struct Waiter {
+        struct Waiter* next;
+        void* data;             //filled in by the producer
+        atomic_uint filled;     //futex word: 0 while parked, 1 once data is valid
+    } fifo_waiter_t;
+
+    struct Combiner; //flat-combining publication slots, defined in fifo.c
+    struct Lane; //fifoPullMinPriority waiters for one threshold, defined in fifo.c
+    struct Realtime; //real-time node pool and priority levels, defined in fifo.c
+    struct SignalRing; //fifoPushSignalSafe ring, defined in fifo_signal.c
+    struct DedupIndex; //fifoPushUnique key index, defined in fifo_dedup.c
+    struct FaaQueue; //FIFO_BACKEND_FAA state, defined in fifo_faa.c
+    struct MultiQueue; //FIFO_BACKEND_MULTIQUEUE state, defined in fifo_multiqueue.c
+    struct SkipList; //FIFO_BACKEND_SKIPLIST state, defined in fifo_skiplist.c
+    struct RadixHeap; //FIFO_BACKEND_RADIX state, defined in fifo_radix.c
+    struct Calendar; //FIFO_BACKEND_CALENDAR state, defined in fifo_calendar.c
+    struct Stack; //FIFO_BACKEND_STACK state, defined in fifo_stack.c
+
     typedef struct Buffer {
-        pthread_mutex_t lock;
-        pthread_cond_t cond_nonfull;
-        pthread_cond_t cond_nonempty;
+        fifo_lock_t lock;
+        fifo_cond_t cond_nonfull;
+        fifo_cond_t cond_nonempty;
         int max_buffer_size;
         int buffer_occupancy;
         fifo_node_t *sentinel;
+        fifo_backend_t backend;
+        union {
+            struct FaaQueue* faa;
+            struct MultiQueue* mq;
+            struct SkipList* skip;
+            struct RadixHeap* radix;
+            struct Calendar* cal;
+            struct Stack* stack;
+        } impl;                         //state of backends other than FIFO_BACKEND_LIST
+        fifo_stats_t stats;
+        char name[FIFO_NAME_MAX];
+        int registry_slot;              //index in the global registry, -1 if unregistered
+        struct Combiner* combiner;      //NULL unless flat combining is enabled
+        bool handoff;
+        fifo_waiter_t* waiters_head;    //parked consumers, oldest first; non-empty only while buffer is empty
+        fifo_waiter_t* waiters_tail;
+        fifo_node_t** staging;          //lazy priority mode: unsorted recent pushes, NULL if disabled
+        int staging_count;
+        int lazy_threshold;
+        fifo_pull_order_t pull_order;
+        pthread_t owner;                //FIFO_ORDER_MIXED: thread that pulls newest first
+        bool has_owner;
+        struct Lane* lanes;             //fifoPullMinPriority wait queues, one per threshold in use
+        struct Realtime* rt;            //NULL unless real-time mode is enabled
+        struct SignalRing* signal_ring; //NULL unless fifoPushSignalSafe is enabled
+        struct DedupIndex* dedup;       //NULL unless fifo_attr_t.dedup is set
     } fifo_buffer_t;
 
     /********* Buffer interaction *********/
     //Push data into FIFO pointed to by buffer. If blocking is false and buffer is full,
     //this function returns -1.
+    //In lazy priority mode (fifo_attr_t.lazy_threshold > 0) the push is an O(1) append to an
+    //unsorted staging area. Staged items are merged into priority order in one pass when a pull,
+    //flush or snapshot needs the ordered view, or when lazy_threshold items are staged. Pull
+    //order is unchanged.
     int fifoPush(fifo_buffer_t* buffer, void* data, int priority, bool blocking);
 
+    //Push data with a 64-bit key into a FIFO_BACKEND_RADIX or FIFO_BACKEND_CALENDAR buffer. Keys
+    //are pulled smallest first, equal keys first-in first-out. Radix keys must be monotone: a key
+    //below the last key pulled is refused with EINVAL. fifoPush on these buffers uses priority as
+    //the key; a negative priority means the last key pulled, so the item is served right after
+    //those already queued with that key. Other backends return EINVAL.
+    int fifoPushKey(fifo_buffer_t* buffer, void* data, uint64_t key, bool blocking);
+
+    //Idempotent push: as fifoPush, unless an item pushed with the same 64-bit key is still
+    //queued, in which case nothing is queued and EEXIST is returned, also when the buffer is
+    //full. With FIFO_DEDUP_EXACT and a dedup_merge callback the queued item's data is replaced
+    //by dedup_merge(queued, data), called under the buffer lock. A key is forgotten when its
+    //item is pulled or flushed. FIFO_DEDUP_FILTER uses O(1) memory per counter instead of per
+    //item but may report EEXIST for a key that is not queued (a false positive), never merges,
+    //and keeps counters that reach 255 set until the next flush. Returns ENOTSUP if the buffer
+    //has no key index. Plain fifoPush items carry no key and never collide.
+    int fifoPushUnique(fifo_buffer_t* buffer, void* data, int priority, uint64_t key, bool blocking);
+
+    //Async-signal-safe push, for use in signal handlers. Stores data into a ring preallocated at
+    //init (fifo_attr_t.signal_ring) with atomic operations only: no lock, no allocation. Consumers
+    //move ring items into the buffer, in priority order, on their next pull, flush or snapshot,
+    //and are woken through cond_nonempty's futex and the optional eventfd. Returns 0, -1 if the
+    //ring is full, or ENOTSUP if the buffer has no ring. Direct hand-off is disabled on such
+    //buffers, and fifoPullMinPriority is not supported.
+    int fifoPushSignalSafe(fifo_buffer_t* buffer, void* data, int priority);
+
+    //Returns the eventfd signalled by fifoPushSignalSafe (fifo_attr_t.signal_eventfd), or -1. The
+    //descriptor is non-blocking and owned by the buffer; event loops poll it, read(2) it to reset
+    //the count, then pull without blocking until the buffer is empty.
+    int fifoSignalFd(fifo_buffer_t* buffer);
+
+    //Push count items as if by count fifoPush calls in array order, with one lock acquisition and
+    //one merged pass over the buffer. priorities may be NULL for all 0. The whole batch waits for
+    //room (blocking) or is refused with -1; a batch larger than the capacity is always refused,
+    //except on FIFO_BACKEND_FAA, which has none.
+    int fifoPushBatch(fifo_buffer_t* buffer, void** data, const int* priorities, int count, bool blocking);
+
     //Pull next data from FIFO pointed to by buffer. If blocking is false and buffer is empty,
     //this function returns NULL.
     void* fifoPull(fifo_buffer_t* buffer, bool blocking);
 
+    //Pull the next data only if its priority is negative or at least threshold, so dedicated
+    //consumers can serve urgent items without picking up long low-priority work. If blocking is
+    //true, waits until such an item arrives; only pushes that qualify wake the caller. Returns
+    //NULL otherwise. List backend in FIFO_ORDER_FIFO with priorities enabled only, and not in
+    //real-time mode; elsewhere returns NULL with errno set to ENOTSUP.
+    void* fifoPullMinPriority(fifo_buffer_t* buffer, int threshold, bool blocking);
+
     // Empties FIFO, returning the contents in a NULL terminated array in first-out order (i.e. index 0 is first out) 
     // If blocking is false and buffer is full, this function returns -1.
     void** fifoFlush(fifo_buffer_t* buffer, bool blocking);
     /**************************************/
     /////////////////////////////////////////////////////////////////
 
-    //Returns pointer to initialized FIFO with capacity of max_buffer_size
-    fifo_buffer_t* fifoBufferInit(int max_buffer_size); //buffer instantiation
+    //Returns pointer to initialized FIFO with capacity of max_buffer_size.
+    //If name is non-NULL the buffer is registered for fifoRegistryDump(); names longer than
+    //FIFO_NAME_MAX-1 are truncated. Pass NULL to keep the buffer out of the registry.
+    fifo_buffer_t* fifoBufferInit(int max_buffer_size, const char* name); //buffer instantiation
+
+    //Fills attr with the compile-time defaults from fifo_config.h
+    void fifoAttrInit(fifo_attr_t* attr);
+
+    //As fifoBufferInit, with per-buffer options. attr may be NULL for defaults. Returns NULL on failure.
+    //With attr->realtime on the list backend, the buffer, its lock and all nodes are preallocated
+    //and mlock'ed (a failed mlock is reported with perror and tolerated), the lock is
+    //FIFO_LOCK_PI, and push and pull take a bounded number of steps: priorities are bucketed
+    //into FIFO_RT_PRIO_LEVELS levels.
+    //Combining, lazy ordering, non-FIFO pull orders and fifoPullMinPriority are turned off;
+    //fifoPushBatch pushes item by item. fifoFlush and fifoBufferClose still allocate their result array.
+    //With attr->lock_kind FIFO_LOCK_NONE on the list, radix or calendar backend the buffer is for
+    //one thread only: no locks, no atomics, no wake-ups. Combining and hand-off are turned off,
+    //the buffer is not registered (a dump would read it from another thread), and a blocking
+    //push on a full or pull on an empty buffer returns at once, as a non-blocking one would
+    //except that push reports EDEADLK. Debug builds assert on use from a second thread.
+    fifo_buffer_t* fifoBufferInitAttr(int max_buffer_size, const char* name, const fifo_attr_t* attr);
     
+    //Makes the calling thread the owner of a FIFO_ORDER_MIXED buffer: its pulls take the most
+    //recently pushed item, the one most likely still in its cache, while other threads take the
+    //oldest, as in work stealing. Call before the buffer is shared or while it is quiescent.
+    void fifoBufferSetOwner(fifo_buffer_t* buffer);
+
     //Frees resources allocated for FIFO. Returns contents in a NULL terminated array in first-out order
     void** fifoBufferClose(fifo_buffer_t* buffer); //buffer destructor
 
-    //Debugging function that prints the contents of the FIFO buffer
+    //Copies the buffer statistics into *stats_out. Returns 0 on success or the locking error.
+    int fifoGetStats(fifo_buffer_t* buffer, fifo_stats_t* stats_out);
+
+    //Returns a human readable name for a backend
+    const char* fifoBackendName(fifo_backend_t backend);
+
+    //Writes one line per live, named buffer to stream: name, capacity, occupancy, stats and backend.
+    //Registration and removal are lock-free; the dump briefly locks each buffer to copy its counters.
+    void fifoRegistryDump(FILE* stream);
+
+    /********* Diagnostics *********/
+    //One queued element as captured by fifoSnapshot
+    typedef struct SnapshotEntry {
+        int position;       //0 is the next element fifoPull would return
+        int priority;       //FIFO_BACKEND_RADIX/CALENDAR: the key, saturated at INT_MAX
+        uint64_t age_ns;    //time spent in the buffer when the snapshot was taken
+        void* data;         //data pointer only; the pointee is not copied
+    } fifo_snapshot_entry_t;
+
+    //Buffer metadata captured by fifoSnapshot. entries points to caller-provided storage
+    typedef struct Snapshot {
+        int capacity;
+        int occupancy;
+        fifo_stats_t stats;
+        uint64_t taken_ns;                  //CLOCK_MONOTONIC time of the capture
+        int count;                          //number of valid elements in entries
+        fifo_snapshot_entry_t* entries;
+    } fifo_snapshot_t;
+
+    //Copies metadata of up to max_entries queued elements, in first-out order, into entries
+    //and fills *snap. Only the copy happens under the buffer lock; no allocation or I/O is
+    //done while it is held. If blocking is false and the buffer is busy, the locking error
+    //is returned and *snap is left untouched. Returns 0 on success.
+    int fifoSnapshot(fifo_buffer_t* buffer, fifo_snapshot_t* snap, fifo_snapshot_entry_t* entries, int max_entries, bool blocking);
+
+    //Formats snap as text into out, writing at most out_len bytes including the NULL terminator.
+    //Returns the length the full text would have, as snprintf does. Does not touch the buffer.
+    int fifoSnapshotFormat(const fifo_snapshot_t* snap, char* out, size_t out_len);
+    /*******************************/
+
+    //Debugging function that prints the contents of the FIFO buffer to stdout.
+    //Superseded by fifoSnapshot/fifoSnapshotFormat; kept for compatibility.
     void fifoPrint(fifo_buffer_t* buffer); //for debugging
 
     //Alternative, UNUSED method of determingin buffer occupancy via traversing entirety of list.
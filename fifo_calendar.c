@@ -0,0 +1,383 @@
+/**
+ * Description: Calendar queue backend (FIFO_BACKEND_CALENDAR), after R. Brown, "Calendar
+ *  Queues: A Fast O(1) Priority Queue Implementation for the Simulation Event Set Problem".
+ *  Keys are event times, served smallest first, equal keys first-in first-out. The key space
+ *  is cut into days of `width` keys; day d lives in bucket d mod nbuckets, a short list sorted
+ *  by key. A pull scans forward from the current day and takes the head of a bucket if it
+ *  falls within that day, so both push and pull are O(1) expected when events are spread
+ *  evenly over about one per day.
+ *
+ *  The calendar resizes itself: the bucket count doubles when the queue holds more than two
+ *  events per bucket and halves below one half. On each resize the day width is re-estimated
+ *  as three times the average gap between the next few events, ignoring outlying gaps, so
+ *  the calendar follows the event distribution as it changes. Unlike the radix backend, keys
+ *  below the current time are accepted and simply become the next events.
+ *
+ *  Protected by the buffer lock and waiting on the buffer conditions, as the list backend.
+ **/
+#include "fifo_internal.h"
+#include <limits.h>
+
+#define CAL_SAMPLE 25   //events sampled to estimate the day width on resize
+
+typedef struct CalNode {
+    struct CalNode* next;
+    void* data;
+    uint64_t key;
+    uint64_t enqueue_ns;
+} fifo_cal_node_t;
+
+typedef struct Calendar {
+    fifo_cal_node_t** buckets;
+    int nbuckets;               //power of two
+    int count;
+    uint64_t width;             //keys per day, at least 1
+    int last_bucket;            //bucket of the current day
+    uint64_t bucket_top;        //first key after the current day
+    uint64_t last_key;          //key of the last event pulled, or an earlier key pushed since
+} fifo_cal_t;
+
+static uint64_t calAddSat(uint64_t a, uint64_t b) 
+{
+    uint64_t sum;
+    return __builtin_add_overflow(a, b, &sum) ? UINT64_MAX : sum;
+}
+
+//Makes the day containing key the current day
+static void calSetDay(fifo_cal_t* cal, uint64_t key) 
+{
+    uint64_t day = key / cal->width;
+    cal->last_bucket = (int) (day & (uint64_t) (cal->nbuckets - 1));
+    cal->bucket_top = calAddSat(day * cal->width, cal->width);
+    cal->last_key = key;
+}
+
+/**Links node into its bucket, after nodes of equal key, or before them if before_equal is set **/
+static void calInsert(fifo_cal_t* cal, fifo_cal_node_t* node, bool before_equal) 
+{
+    fifo_cal_node_t** link = &cal->buckets[(node->key / cal->width) & (uint64_t) (cal->nbuckets - 1)];
+    while (*link != NULL && ((*link)->key < node->key || (!before_equal && (*link)->key == node->key))) link = &(*link)->next;
+    node->next = *link;
+    *link = node;
+    cal->count++;
+    if (node->key < cal->last_key) calSetDay(cal, node->key); //earlier than the scan position
+}
+
+/**Removes the smallest-key node without resizing. The calendar must be non-empty **/
+static fifo_cal_node_t* calPopRaw(fifo_cal_t* cal) 
+{
+    int i = cal->last_bucket;
+    uint64_t top = cal->bucket_top;
+    for (int n = 0; n < cal->nbuckets; n++) 
+    {
+        fifo_cal_node_t* head = cal->buckets[i];
+        if (head != NULL && head->key < top) 
+        {
+            cal->buckets[i] = head->next;
+            cal->count--;
+            cal->last_bucket = i;
+            cal->bucket_top = top;
+            cal->last_key = head->key;
+            return head;
+        }
+        i = (i + 1) & (cal->nbuckets - 1);
+        top = calAddSat(top, cal->width);
+    } //one year scanned without a hit: the events are sparse, search directly
+
+    int min = -1;
+    for (i = 0; i < cal->nbuckets; i++) 
+    {
+        if (cal->buckets[i] != NULL && (min < 0 || cal->buckets[i]->key < cal->buckets[min]->key)) min = i;
+    }
+    fifo_cal_node_t* head = cal->buckets[min];
+    cal->buckets[min] = head->next;
+    cal->count--;
+    calSetDay(cal, head->key);
+    return head;
+}
+
+/**Rebuilds the calendar with nbuckets buckets and a day width estimated from the next
+ * CAL_SAMPLE events. Keeps the old table if allocation fails **/
+static void calResize(fifo_cal_t* cal, int nbuckets) 
+{
+    fifo_cal_node_t* sample = NULL;
+    fifo_cal_node_t** sample_tail = &sample;
+    int sampled = 0;
+    uint64_t first = 0, prev = 0, gaps[CAL_SAMPLE];
+    while (sampled < CAL_SAMPLE && cal->count > 0) 
+    {
+        fifo_cal_node_t* node = calPopRaw(cal);
+        if (sampled == 0) first = node->key;
+        else gaps[sampled - 1] = node->key - prev;
+        prev = node->key;
+        *sample_tail = node;
+        sample_tail = &node->next;
+        sampled++;
+    } //sampled nodes leave in pull order and are put back first, so ties keep their order
+    *sample_tail = NULL;
+
+    uint64_t width = cal->width;
+    if (sampled > 1) 
+    {
+        uint64_t sum = 0;
+        for (int i = 0; i < sampled - 1; i++) sum += gaps[i];
+        uint64_t avg = sum / (sampled - 1);
+        uint64_t sum2 = 0;
+        int n2 = 0;
+        for (int i = 0; i < sampled - 1; i++) 
+        {
+            if (gaps[i] > 2 * avg) continue;
+            sum2 += gaps[i];
+            n2++;
+        }
+        if (n2 > 0) avg = sum2 / n2;
+        width = avg > UINT64_MAX / 3 ? UINT64_MAX / 3 : 3 * avg;
+        if (width == 0) width = 1;
+    }
+
+    fifo_cal_node_t** old = cal->buckets;
+    int old_n = cal->nbuckets;
+    fifo_cal_node_t** fresh = (fifo_cal_node_t**) calloc(nbuckets, sizeof(fifo_cal_node_t*));
+    if (fresh != NULL) 
+    {
+        cal->buckets = fresh;
+        cal->nbuckets = nbuckets;
+        cal->width = width;
+    }
+    else 
+    {
+        old = NULL;
+        old_n = 0;
+    } //out of memory: only put the sample back
+
+    int remaining = cal->count;
+    cal->count = 0;
+    calSetDay(cal, sampled > 0 ? first : cal->last_key);
+
+    //Put the sample back in pull order, after nothing of equal key on a fresh table and before
+    //the equal keys still queued on the old one
+    if (old == NULL) 
+    {
+        cal->count = remaining;
+        fifo_cal_node_t* rev = NULL;
+        while (sample != NULL) 
+        {
+            fifo_cal_node_t* next = sample->next;
+            sample->next = rev;
+            rev = sample;
+            sample = next;
+        }
+        while (rev != NULL) 
+        {
+            fifo_cal_node_t* next = rev->next;
+            calInsert(cal, rev, true);
+            rev = next;
+        }
+        return;
+    }
+    while (sample != NULL) 
+    {
+        fifo_cal_node_t* next = sample->next;
+        calInsert(cal, sample, false);
+        sample = next;
+    }
+    for (int i = 0; i < old_n; i++) 
+    {
+        fifo_cal_node_t* p = old[i];
+        while (p != NULL) 
+        {
+            fifo_cal_node_t* next = p->next;
+            calInsert(cal, p, false);
+            p = next;
+        }
+    } //equal keys share an old bucket in push order, so they are reinserted in that order
+    free(old);
+}
+
+struct Calendar* fifoCalCreate(void) 
+{
+    fifo_cal_t* cal = (fifo_cal_t*) calloc(1, sizeof(fifo_cal_t));
+    if (cal == NULL) return NULL;
+    cal->nbuckets = FIFO_CALENDAR_MIN_BUCKETS;
+    cal->buckets = (fifo_cal_node_t**) calloc(cal->nbuckets, sizeof(fifo_cal_node_t*));
+    if (cal->buckets == NULL) 
+    {
+        free(cal);
+        return NULL;
+    }
+    cal->width = 1;
+    calSetDay(cal, 0);
+    return cal;
+}
+
+void fifoCalDestroy(struct Calendar* cal) 
+{
+    for (int i = 0; i < cal->nbuckets; i++) 
+    {
+        fifo_cal_node_t* p = cal->buckets[i];
+        while (p != NULL) 
+        {
+            fifo_cal_node_t* next = p->next;
+            free(p);
+            p = next;
+        }
+    }
+    free(cal->buckets);
+    free(cal);
+}
+
+/**Pushes data with the given key, or with the key of the last event pulled if at_last is set **/
+int fifoCalPush(fifo_buffer_t* buffer, void* data, uint64_t key, bool at_last, bool blocking) 
+{
+    fifo_cal_t* cal = buffer->impl.cal;
+    fifo_cal_node_t* node = (fifo_cal_node_t*) malloc(sizeof(fifo_cal_node_t));
+    if (node == NULL) return ENOMEM;
+    node->data = data;
+    node->enqueue_ns = fifoNowNs();
+
+    int lock_status = fifoLockBuffer(buffer,blocking);
+    if (lock_status != 0) 
+    {
+        free(node);
+        return lock_status;
+    }
+
+    while (buffer->buffer_occupancy >= buffer->max_buffer_size) 
+    {
+        if (blocking) 
+        {
+            unsigned seq = fifoCondPrepare(&buffer->cond_nonfull);
+            int cond_status = fifoCondWait(&buffer->cond_nonfull, &buffer->lock, seq);
+            if (cond_status != 0) 
+            {
+                free(node);
+                return cond_status;
+            }
+        } //loop guards against spurious wake-ups
+        else 
+        {
+#if FIFO_ENABLE_STATS
+            buffer->stats.push_rejects++;
+#endif
+            fifoLockRelease(&buffer->lock);
+            free(node);
+            return -1;
+        }
+    }
+
+    node->key = at_last ? cal->last_key : key;
+    calInsert(cal, node, false);
+    if (cal->count > 2 * cal->nbuckets && cal->nbuckets <= INT_MAX / 2) calResize(cal, 2 * cal->nbuckets);
+
+    buffer->buffer_occupancy++;
+#if FIFO_ENABLE_STATS
+    buffer->stats.pushes++;
+    if (buffer->buffer_occupancy > buffer->stats.peak_occupancy) buffer->stats.peak_occupancy = buffer->buffer_occupancy;
+#endif
+
+    fifoCondSignal(&buffer->cond_nonempty);
+    fifoLockRelease(&buffer->lock);
+    return 0;
+}
+
+//Removes the smallest-key node. Caller holds the lock and has verified the calendar is non-empty
+static fifo_cal_node_t* calPopLocked(fifo_buffer_t* buffer) 
+{
+    fifo_cal_t* cal = buffer->impl.cal;
+    fifo_cal_node_t* node = calPopRaw(cal);
+    if (cal->count < cal->nbuckets / 2 && cal->nbuckets > FIFO_CALENDAR_MIN_BUCKETS) calResize(cal, cal->nbuckets / 2);
+
+    buffer->buffer_occupancy--;
+#if FIFO_ENABLE_STATS
+    buffer->stats.pulls++;
+#endif
+    return node;
+}
+
+void* fifoCalPull(fifo_buffer_t* buffer, bool blocking) 
+{
+    int lock_status = fifoLockBuffer(buffer,blocking);
+    if (lock_status != 0) return NULL;
+
+    while (buffer->buffer_occupancy <= 0) 
+    {
+        if (blocking) 
+        {
+            unsigned seq = fifoCondPrepare(&buffer->cond_nonempty);
+            if (fifoCondWait(&buffer->cond_nonempty, &buffer->lock, seq) != 0) return NULL;
+        } //loop guards against spurious wake-ups
+        else 
+        {
+            fifoLockRelease(&buffer->lock);
+            return NULL;
+        }
+    }
+
+    fifo_cal_node_t* node = calPopLocked(buffer);
+    fifoCondSignal(&buffer->cond_nonfull);
+    fifoLockRelease(&buffer->lock);
+
+    void* data = node->data;
+    free(node);
+    return data;
+}
+
+void** fifoCalFlush(fifo_buffer_t* buffer, bool blocking) 
+{
+    int lock_status = fifoLockBuffer(buffer,blocking);
+    if (lock_status != 0) return NULL;
+
+    fifo_cal_t* cal = buffer->impl.cal;
+    void** out = (void**) calloc(buffer->buffer_occupancy + 1, sizeof(void*));
+    int i = 0;
+    while (cal->count > 0) 
+    {
+        fifo_cal_node_t* node = calPopRaw(cal); //no shrinking while draining
+        out[i++] = node->data;
+        free(node);
+    }
+    out[i] = NULL;
+    buffer->buffer_occupancy = 0;
+#if FIFO_ENABLE_STATS
+    buffer->stats.pulls += i;
+#endif
+
+    fifoCondBroadcast(&buffer->cond_nonfull);
+    fifoLockRelease(&buffer->lock);
+    return out;
+}
+
+int fifoCalSnapshotLocked(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries, uint64_t now) 
+{
+    fifo_cal_t* cal = buffer->impl.cal;
+    int saved_bucket = cal->last_bucket;
+    uint64_t saved_top = cal->bucket_top;
+    uint64_t saved_key = cal->last_key;
+
+    //Pull up to max_entries nodes without resizing, then put them back in reverse, each before
+    //the equal keys still queued, which restores the exact previous state
+    fifo_cal_node_t* taken = NULL;
+    int count = 0;
+    while (count < max_entries && cal->count > 0) 
+    {
+        fifo_cal_node_t* p = calPopRaw(cal);
+        entries[count].position = count;
+        entries[count].priority = p->key > INT_MAX ? INT_MAX : (int) p->key; //saturates; see fifo_snapshot_entry_t
+        entries[count].age_ns = now - p->enqueue_ns;
+        entries[count].data = p->data;
+        count++;
+        p->next = taken;
+        taken = p;
+    }
+    while (taken != NULL) 
+    {
+        fifo_cal_node_t* next = taken->next;
+        calInsert(cal, taken, true);
+        taken = next;
+    }
+
+    cal->last_bucket = saved_bucket;
+    cal->bucket_top = saved_top;
+    cal->last_key = saved_key;
+    return count;
+}
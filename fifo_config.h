@@ -0,0 +1,103 @@
+/**
+ * Description: Compile-time feature selection for the FIFO library.
+ *  Every macro can be overridden on the compiler command line (e.g. -DFIFO_ENABLE_STATS=0).
+ *  Struct layouts do not depend on these settings, but an application should be built with
+ *  the same values as the library variant it links against so the documented behaviour matches.
+ *
+ *  The Makefile ships these variants:
+ *   libfifo.a          all features, lock kind chosen by NDEBUG (error-checking mutex by default)
+ *   libfifo_release.a  all features, adaptive mutex
+ *   libfifo_plain.a    plain FIFO: no priority ordering, no statistics, no registry, adaptive mutex
+ *   libfifo_st.a       single-threaded: buffers default to FIFO_LOCK_NONE and no hand-off
+ **/
+
+#ifndef _FIFO_CONFIG_H_
+#define _FIFO_CONFIG_H_
+
+    //Priority ordering in fifoPush. When 0 the priority argument is ignored and every
+    //push is an O(1) append, giving strict first-in first-out order
+    #ifndef FIFO_ENABLE_PRIORITY
+    #define FIFO_ENABLE_PRIORITY 1
+    #endif
+
+    //Push/pull counters, peak occupancy and node enqueue timestamps. When 0, fifoGetStats
+    //and snapshots report only the current occupancy, and snapshot ages read 0
+    #ifndef FIFO_ENABLE_STATS
+    #define FIFO_ENABLE_STATS 1
+    #endif
+
+    //Global buffer registry. When 0, names are still stored but fifoRegistryDump lists nothing
+    #ifndef FIFO_ENABLE_REGISTRY
+    #define FIFO_ENABLE_REGISTRY 1
+    #endif
+
+    //Default lock strategy (a fifo_lock_kind_t value, see fifo_lock.h). Debug builds get the
+    //error-checking mutex; builds with NDEBUG get the adaptive mutex. Overridable per buffer
+    //through fifo_attr_t. FIFO_LOCK_NONE makes every buffer single-threaded by default
+    #ifndef FIFO_MUTEX_KIND
+        #ifdef NDEBUG
+        #define FIFO_MUTEX_KIND FIFO_LOCK_ADAPTIVE
+        #else
+        #define FIFO_MUTEX_KIND FIFO_LOCK_ERRORCHECK
+        #endif
+    #endif
+
+    //Default for fifo_attr_t.handoff. When enabled, a consumer blocked on an empty buffer parks
+    //on its own futex word and the next push hands it the data pointer directly, skipping node
+    //allocation and list manipulation; the consumer returns without re-acquiring the lock
+    #ifndef FIFO_ENABLE_HANDOFF
+    #define FIFO_ENABLE_HANDOFF 1
+    #endif
+
+    //Publication slots per flat-combining buffer. Threads beyond this many concurrent
+    //operations take the regular locked path
+    #ifndef FIFO_FC_SLOTS
+    #define FIFO_FC_SLOTS 32
+    #endif
+
+    //Cells per segment of the FAA backend, and retired segments kept for reuse process-wide
+    #ifndef FIFO_FAA_SEGMENT_SIZE
+    #define FIFO_FAA_SEGMENT_SIZE 1024
+    #endif
+    #ifndef FIFO_FAA_SPARE_SEGMENTS
+    #define FIFO_FAA_SPARE_SEGMENTS 16
+    #endif
+
+    //FIFO_BACKEND_MULTIQUEUE: heaps per expected thread (c), and one rank-error sample per
+    //this many pulls of each thread
+    #ifndef FIFO_MQ_FACTOR
+    #define FIFO_MQ_FACTOR 2
+    #endif
+    #ifndef FIFO_MQ_RANK_SAMPLE
+    #define FIFO_MQ_RANK_SAMPLE 64
+    #endif
+
+    //FIFO_BACKEND_SKIPLIST: deleted-prefix length at which a pull unlinks the prefix
+    #ifndef FIFO_SKIPLIST_BOUND
+    #define FIFO_SKIPLIST_BOUND 32
+    #endif
+
+    //FIFO_BACKEND_CALENDAR: initial and minimum bucket count, a power of two
+    #ifndef FIFO_CALENDAR_MIN_BUCKETS
+    #define FIFO_CALENDAR_MIN_BUCKETS 16
+    #endif
+
+    //Real-time mode (fifo_attr_t.realtime): number of distinct priority levels, at most 64.
+    //Priorities at or above FIFO_RT_PRIO_LEVELS-1 share the top level, first-in first-out
+    #ifndef FIFO_RT_PRIO_LEVELS
+    #define FIFO_RT_PRIO_LEVELS 64
+    #endif
+    #if FIFO_RT_PRIO_LEVELS < 1 || FIFO_RT_PRIO_LEVELS > 64
+    #error "FIFO_RT_PRIO_LEVELS must be between 1 and 64"
+    #endif
+
+    //Strand executor: tasks a worker runs from one strand before giving others a turn
+    #ifndef FIFO_STRAND_BATCH
+    #define FIFO_STRAND_BATCH 32
+    #endif
+
+    //Default storage engine (a fifo_backend_t value). Overridable per buffer through fifo_attr_t
+    #ifndef FIFO_BACKEND
+    #define FIFO_BACKEND FIFO_BACKEND_LIST
+    #endif
+#endif
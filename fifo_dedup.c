@@ -0,0 +1,159 @@
+/**
+ * Description: Key index behind fifoPushUnique. Two interchangeable structures:
+ *  FIFO_DEDUP_EXACT is an open-addressing hash table of (key, node) pairs with linear
+ *  probing, sized at twice the buffer capacity so the load factor never exceeds 1/2 and no
+ *  resize is ever needed. Deletion uses backward shifting instead of tombstones: entries
+ *  after the hole move back into it unless that would place them before their home slot,
+ *  so lookups stay short however long the buffer runs.
+ *
+ *  FIFO_DEDUP_FILTER is a counting Bloom filter of 8-bit counters and FIFO_DEDUP_HASHES
+ *  probes per key. A key is reported present when all of its counters are non-zero. Counters
+ *  saturate at 255 and are then never decremented, which can only add false positives.
+ *
+ *  Both are protected by the buffer lock.
+ **/
+#include "fifo_internal.h"
+#include <string.h>
+
+#define FIFO_DEDUP_HASHES 4
+
+typedef struct DedupEntry {
+    uint64_t key;
+    fifo_node_t* node;      //NULL for an empty slot
+} fifo_dedup_entry_t;
+
+typedef struct DedupIndex {
+    fifo_dedup_mode_t mode;
+    size_t mask;
+    void* (*merge)(void* queued, void* incoming);
+    fifo_dedup_entry_t* entries;    //FIFO_DEDUP_EXACT
+    uint8_t* counters;              //FIFO_DEDUP_FILTER
+} fifo_dedup_t;
+
+static uint64_t dedupHash(uint64_t key) 
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    return key ^ (key >> 31);
+} //splitmix64 finalizer
+
+//Counter of probe n for key: double hashing, odd stride so the probes differ
+static size_t dedupCounter(const fifo_dedup_t* index, uint64_t hash, int n) 
+{
+    uint64_t stride = (hash >> 32 | hash << 32) | 1;
+    return (size_t) (hash + n * stride) & index->mask;
+}
+
+struct DedupIndex* fifoDedupCreate(const fifo_attr_t* attr, int capacity) 
+{
+    size_t wanted = attr->dedup == FIFO_DEDUP_FILTER ?
+        (attr->dedup_filter_counters > 0 ? (size_t) attr->dedup_filter_counters : 8 * (size_t) capacity) :
+        2 * (size_t) capacity;
+    size_t size = 16;
+    while (size < wanted) size <<= 1;
+
+    fifo_dedup_t* index = (fifo_dedup_t*) calloc(1, sizeof(fifo_dedup_t));
+    if (index == NULL) return NULL;
+    index->mode = attr->dedup;
+    index->mask = size - 1;
+    index->merge = attr->dedup == FIFO_DEDUP_EXACT ? attr->dedup_merge : NULL;
+    if (index->mode == FIFO_DEDUP_FILTER) index->counters = (uint8_t*) calloc(size, sizeof(uint8_t));
+    else index->entries = (fifo_dedup_entry_t*) calloc(size, sizeof(fifo_dedup_entry_t));
+    if (index->counters == NULL && index->entries == NULL) 
+    {
+        free(index);
+        return NULL;
+    }
+    return index;
+}
+
+void fifoDedupDestroy(struct DedupIndex* index) 
+{
+    free(index->entries);
+    free(index->counters);
+    free(index);
+}
+
+//Slot holding key, or the empty slot ending its probe sequence
+static size_t dedupSlot(const fifo_dedup_t* index, uint64_t key) 
+{
+    size_t i = dedupHash(key) & index->mask;
+    while (index->entries[i].node != NULL && index->entries[i].key != key) i = (i + 1) & index->mask;
+    return i;
+}
+
+/**Returns true if key is queued (FIFO_DEDUP_FILTER: probably queued). For FIFO_DEDUP_EXACT
+ * *node receives its node, otherwise NULL **/
+bool fifoDedupFind(struct DedupIndex* index, uint64_t key, fifo_node_t** node) 
+{
+    *node = NULL;
+    if (index->mode == FIFO_DEDUP_FILTER) 
+    {
+        uint64_t hash = dedupHash(key);
+        for (int n = 0; n < FIFO_DEDUP_HASHES; n++) 
+        {
+            if (index->counters[dedupCounter(index, hash, n)] == 0) return false;
+        }
+        return true;
+    }
+    *node = index->entries[dedupSlot(index, key)].node;
+    return *node != NULL;
+}
+
+//Folds data into a queued node if a merge callback is set; otherwise the duplicate is dropped
+void fifoDedupMerge(struct DedupIndex* index, fifo_node_t* node, void* data) 
+{
+    if (index->merge != NULL && node != NULL) node->data = index->merge(node->data, data);
+}
+
+//Records key for node. key must not be present (FIFO_DEDUP_EXACT)
+void fifoDedupInsert(struct DedupIndex* index, uint64_t key, fifo_node_t* node) 
+{
+    if (index->mode == FIFO_DEDUP_FILTER) 
+    {
+        uint64_t hash = dedupHash(key);
+        for (int n = 0; n < FIFO_DEDUP_HASHES; n++) 
+        {
+            uint8_t* counter = &index->counters[dedupCounter(index, hash, n)];
+            if (*counter < UINT8_MAX) (*counter)++;
+        }
+        return;
+    }
+    size_t i = dedupSlot(index, key);
+    index->entries[i].key = key;
+    index->entries[i].node = node;
+}
+
+void fifoDedupRemove(struct DedupIndex* index, uint64_t key) 
+{
+    if (index->mode == FIFO_DEDUP_FILTER) 
+    {
+        uint64_t hash = dedupHash(key);
+        for (int n = 0; n < FIFO_DEDUP_HASHES; n++) 
+        {
+            uint8_t* counter = &index->counters[dedupCounter(index, hash, n)];
+            if (*counter > 0 && *counter < UINT8_MAX) (*counter)--;
+        } //a saturated counter has lost its count and must stay set
+        return;
+    }
+
+    size_t hole = dedupSlot(index, key);
+    if (index->entries[hole].node == NULL) return;
+    for (size_t j = (hole + 1) & index->mask; index->entries[j].node != NULL; j = (j + 1) & index->mask) 
+    {
+        size_t home = dedupHash(index->entries[j].key) & index->mask;
+        bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j); //home cyclically in (hole, j]
+        if (stays) continue;
+        index->entries[hole] = index->entries[j];
+        hole = j;
+    } //shift back every entry the hole would cut off from its home slot
+    index->entries[hole].node = NULL;
+}
+
+void fifoDedupClear(struct DedupIndex* index) 
+{
+    if (index->counters != NULL) memset(index->counters, 0, index->mask + 1);
+    else memset(index->entries, 0, (index->mask + 1) * sizeof(fifo_dedup_entry_t));
+}
@@ -0,0 +1,166 @@
+/**
+ * Description: Epoch-based reclamation (Fraser). See fifo_epoch.h
+ *  A global epoch advances once every active thread has observed it. Objects retired in
+ *  epoch e are released once the global epoch reaches e + 2, since by then no thread can
+ *  still be inside a critical section that began before the object was unlinked.
+ *  Each thread keeps three limbo bags, one per epoch modulo 3.
+ **/
+#include "fifo_epoch.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+//Retirements between attempts to advance the global epoch
+#ifndef FIFO_EPOCH_ADVANCE_INTERVAL
+#define FIFO_EPOCH_ADVANCE_INTERVAL 64
+#endif
+
+#define EPOCH_ACTIVE 1u     //low bit of a record's epoch word: thread is inside a critical section
+
+typedef struct Retired {
+    void* ptr;
+    void (*release)(void*);
+} fifo_retired_t;
+
+typedef struct LimboBag {
+    unsigned epoch;         //epoch the contents were retired in
+    int count;
+    int capacity;
+    fifo_retired_t* items;
+} fifo_limbo_bag_t;
+
+typedef struct EpochRecord {
+    atomic_uint local;                  //(observed epoch << 1) | EPOCH_ACTIVE
+    atomic_bool in_use;                 //owned by a live thread
+    struct EpochRecord* next;           //global record list; records are never freed
+    int depth;                          //critical section nesting
+    unsigned retire_count;
+    fifo_limbo_bag_t bags[3];
+} __attribute__((aligned(64))) fifo_epoch_record_t;
+
+static atomic_uint global_epoch;
+static _Atomic(fifo_epoch_record_t*) records;
+
+static pthread_key_t record_key;
+static pthread_once_t record_key_once = PTHREAD_ONCE_INIT;
+static __thread fifo_epoch_record_t* my_record;
+
+//Thread exit: give the record back. Its limbo bags stay with it and are drained by the next owner
+static void epochRecordRelease(void* record) 
+{
+    atomic_store_explicit(&((fifo_epoch_record_t*) record)->in_use, false, memory_order_release);
+}
+
+static void epochKeyCreate(void) 
+{
+    pthread_key_create(&record_key, epochRecordRelease);
+}
+
+static fifo_epoch_record_t* epochRecord(void) 
+{
+    if (my_record != NULL) return my_record;
+    pthread_once(&record_key_once, epochKeyCreate);
+
+    fifo_epoch_record_t* record;
+    for (record = atomic_load(&records); record != NULL; record = record->next) 
+    {
+        bool expected = false;
+        if (!atomic_load_explicit(&record->in_use, memory_order_relaxed) &&
+            atomic_compare_exchange_strong(&record->in_use, &expected, true)) break;
+    } //adopt a record left behind by an exited thread
+
+    if (record == NULL) 
+    {
+        if (posix_memalign((void**) &record, 64, sizeof(fifo_epoch_record_t)) != 0) abort();
+        atomic_init(&record->local, 0);
+        atomic_init(&record->in_use, true);
+        record->depth = 0;
+        record->retire_count = 0;
+        for (int i = 0; i < 3; i++) record->bags[i] = (fifo_limbo_bag_t) {0, 0, 0, NULL};
+
+        fifo_epoch_record_t* head = atomic_load(&records);
+        do record->next = head;
+        while (!atomic_compare_exchange_weak(&records, &head, record));
+    }
+
+    pthread_setspecific(record_key, record);
+    my_record = record;
+    return record;
+}
+
+void fifoEpochEnter(void) 
+{
+    fifo_epoch_record_t* record = epochRecord();
+    if (record->depth++ > 0) return;
+
+    //Re-check after announcing: an advance that scanned before the store must not be missed
+    unsigned epoch;
+    do 
+    {
+        epoch = atomic_load_explicit(&global_epoch, memory_order_relaxed);
+        atomic_store_explicit(&record->local, (epoch << 1) | EPOCH_ACTIVE, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst); //announcement must be visible before any shared load
+    } while (atomic_load_explicit(&global_epoch, memory_order_relaxed) != epoch);
+}
+
+void fifoEpochExit(void) 
+{
+    fifo_epoch_record_t* record = my_record;
+    if (--record->depth > 0) return;
+
+    unsigned local = atomic_load_explicit(&record->local, memory_order_relaxed);
+    atomic_store_explicit(&record->local, local & ~EPOCH_ACTIVE, memory_order_release);
+}
+
+//Advances the global epoch if every active thread has observed the current one
+static void epochTryAdvance(unsigned epoch) 
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    for (fifo_epoch_record_t* record = atomic_load(&records); record != NULL; record = record->next) 
+    {
+        unsigned local = atomic_load_explicit(&record->local, memory_order_relaxed);
+        if ((local & EPOCH_ACTIVE) && (local >> 1) != epoch) return;
+    }
+    atomic_compare_exchange_strong(&global_epoch, &epoch, epoch + 1);
+}
+
+static void bagDrain(fifo_limbo_bag_t* bag) 
+{
+    for (int i = 0; i < bag->count; i++) bag->items[i].release(bag->items[i].ptr);
+    bag->count = 0;
+}
+
+void fifoEpochRetire(void* ptr, void (*release)(void*)) 
+{
+    fifo_epoch_record_t* record = epochRecord();
+    unsigned epoch = atomic_load(&global_epoch);
+
+    if (++record->retire_count % FIFO_EPOCH_ADVANCE_INTERVAL == 0) 
+    {
+        epochTryAdvance(epoch);
+        epoch = atomic_load(&global_epoch);
+    }
+
+    //Any bag not tagged with the current epoch is at least two epochs old; three bags suffice
+    //because the global epoch never runs more than one ahead of an active thread
+    for (int i = 0; i < 3; i++) 
+    {
+        fifo_limbo_bag_t* bag = &record->bags[i];
+        if (bag->count > 0 && epoch - bag->epoch >= 2) bagDrain(bag);
+    }
+
+    fifo_limbo_bag_t* bag = &record->bags[epoch % 3];
+    if (bag->count > 0 && bag->epoch != epoch) bagDrain(bag);
+    bag->epoch = epoch;
+    
+    if (bag->count == bag->capacity) 
+    {
+        int capacity = bag->capacity ? bag->capacity * 2 : 16;
+        fifo_retired_t* items = (fifo_retired_t*) realloc(bag->items, capacity * sizeof(fifo_retired_t));
+        if (items == NULL) abort();
+        bag->items = items;
+        bag->capacity = capacity;
+    }
+    bag->items[bag->count++] = (fifo_retired_t) {ptr, release};
+}
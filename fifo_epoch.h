@@ -0,0 +1,19 @@
+/**
+ * Description: Epoch-based memory reclamation for the lock-free FIFO backends.
+ *  Threads bracket every access to shared lock-free nodes with fifoEpochEnter/fifoEpochExit.
+ *  A node unlinked from a structure is handed to fifoEpochRetire and its release function
+ *  runs only once every thread that could still hold a reference has left its critical
+ *  section. Critical sections may nest. Per-thread records are recycled when threads exit.
+ **/
+
+#ifndef _FIFO_EPOCH_H_
+#define _FIFO_EPOCH_H_
+
+    //Begins / ends a critical section in which lock-free nodes may be dereferenced
+    void fifoEpochEnter(void);
+    void fifoEpochExit(void);
+
+    //Schedules release(ptr) for when no critical section that could observe ptr remains.
+    //Must be called after ptr is unreachable from the shared structure.
+    void fifoEpochRetire(void* ptr, void (*release)(void*));
+#endif
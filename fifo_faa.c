@@ -0,0 +1,241 @@
+/**
+ * Description: Unbounded lock-free MPMC backend (FIFO_BACKEND_FAA), after the
+ *  FAA-array queue of Ramalhete & Correia. The queue is a linked list of array segments.
+ *  Producers and consumers claim array cells with a single fetch-and-add on the segment's
+ *  enqueue/dequeue index, so the common case is one atomic instruction; CAS is only needed
+ *  to fill a claimed cell and when a segment runs out. Drained segments are retired through
+ *  epoch-based reclamation and recycled into a small global pool of spare segments.
+ *
+ *  Priorities are ignored and max_buffer_size is not enforced: pushes never block.
+ *  NULL cannot be pushed because it marks an unfilled cell.
+ **/
+#include "fifo_internal.h"
+#include "fifo_epoch.h"
+#include <string.h>
+
+typedef struct FaaSegment {
+    atomic_int deqidx __attribute__((aligned(64)));
+    atomic_int enqidx __attribute__((aligned(64)));
+    _Atomic(struct FaaSegment*) next __attribute__((aligned(64)));
+    _Atomic(void*) items[FIFO_FAA_SEGMENT_SIZE];
+} fifo_faa_segment_t;
+
+typedef struct FaaQueue {
+    _Atomic(fifo_faa_segment_t*) head __attribute__((aligned(64)));
+    _Atomic(fifo_faa_segment_t*) tail __attribute__((aligned(64)));
+} fifo_faa_t;
+
+static char taken_marker;
+#define FAA_TAKEN ((void*) &taken_marker)   //cell abandoned by a consumer that arrived first
+
+//Retired segments waiting for reuse. Slots are filled and emptied with exchange, so no ABA
+static _Atomic(fifo_faa_segment_t*) spare_segments[FIFO_FAA_SPARE_SEGMENTS];
+
+static void faaSegmentRelease(void* ptr) 
+{
+    fifo_faa_segment_t* segment = (fifo_faa_segment_t*) ptr;
+    for (int i = 0; i < FIFO_FAA_SPARE_SEGMENTS; i++) 
+    {
+        fifo_faa_segment_t* expected = NULL;
+        if (atomic_compare_exchange_strong(&spare_segments[i], &expected, segment)) return;
+    }
+    free(segment);
+}
+
+//New segment holding first in cell 0, taken from the spare pool when possible
+static fifo_faa_segment_t* faaSegmentCreate(void* first) 
+{
+    fifo_faa_segment_t* segment = NULL;
+    for (int i = 0; i < FIFO_FAA_SPARE_SEGMENTS && segment == NULL; i++) 
+    {
+        if (atomic_load_explicit(&spare_segments[i], memory_order_relaxed) != NULL) segment = atomic_exchange(&spare_segments[i], NULL);
+    }
+    if (segment == NULL && posix_memalign((void**) &segment, 64, sizeof(fifo_faa_segment_t)) != 0) return NULL;
+
+    atomic_init(&segment->deqidx, 0);
+    atomic_init(&segment->enqidx, first != NULL ? 1 : 0);
+    atomic_init(&segment->next, NULL);
+    for (int i = 0; i < FIFO_FAA_SEGMENT_SIZE; i++) atomic_init(&segment->items[i], NULL);
+    atomic_store_explicit(&segment->items[0], first, memory_order_relaxed);
+    return segment;
+}
+
+struct FaaQueue* fifoFaaCreate(void) 
+{
+    fifo_faa_t* queue = NULL;
+    if (posix_memalign((void**) &queue, 64, sizeof(fifo_faa_t)) != 0) return NULL;
+    
+    fifo_faa_segment_t* segment = faaSegmentCreate(NULL);
+    if (segment == NULL) 
+    {
+        free(queue);
+        return NULL;
+    }
+    atomic_init(&queue->head, segment);
+    atomic_init(&queue->tail, segment);
+    return queue;
+}
+
+void fifoFaaDestroy(struct FaaQueue* queue) 
+{
+    fifo_faa_segment_t* segment = atomic_load(&queue->head);
+    while (segment != NULL) 
+    {
+        fifo_faa_segment_t* next = atomic_load(&segment->next);
+        free(segment);
+        segment = next;
+    }
+    free(queue);
+
+    for (int i = 0; i < FIFO_FAA_SPARE_SEGMENTS; i++) free(atomic_exchange(&spare_segments[i], NULL));
+} //the pool is shared, so a live queue only loses its spares and allocates afresh
+
+static int faaEnqueue(fifo_faa_t* queue, void* data) 
+{
+    fifoEpochEnter();
+    while (true) 
+    {
+        fifo_faa_segment_t* tail = atomic_load(&queue->tail);
+        int idx = atomic_fetch_add(&tail->enqidx, 1);
+        
+        if (idx < FIFO_FAA_SEGMENT_SIZE) 
+        {
+            void* expected = NULL;
+            if (atomic_compare_exchange_strong(&tail->items[idx], &expected, data)) break;
+            continue; //a consumer gave up on this cell first; claim another
+        } //common case: cell claimed with one fetch-and-add
+
+        if (tail != atomic_load(&queue->tail)) continue;
+        fifo_faa_segment_t* next = atomic_load(&tail->next);
+        if (next == NULL) 
+        {
+            fifo_faa_segment_t* segment = faaSegmentCreate(data);
+            if (segment == NULL) 
+            {
+                fifoEpochExit();
+                return ENOMEM;
+            }
+            
+            fifo_faa_segment_t* expected = NULL;
+            if (atomic_compare_exchange_strong(&tail->next, &expected, segment)) 
+            {
+                atomic_compare_exchange_strong(&queue->tail, &tail, segment);
+                break;
+            }
+            faaSegmentRelease(segment); //never published; safe to recycle immediately
+        } //segment full: append a new one that already holds our item
+        else atomic_compare_exchange_strong(&queue->tail, &tail, next); //help a lagging tail
+    }
+    fifoEpochExit();
+    return 0;
+}
+
+static void* faaDequeue(fifo_faa_t* queue) 
+{
+    void* data = NULL;
+
+    fifoEpochEnter();
+    while (true) 
+    {
+        fifo_faa_segment_t* head = atomic_load(&queue->head);
+        if (atomic_load(&head->deqidx) >= atomic_load(&head->enqidx) && atomic_load(&head->next) == NULL) break;
+
+        int idx = atomic_fetch_add(&head->deqidx, 1);
+        if (idx >= FIFO_FAA_SEGMENT_SIZE) 
+        {
+            fifo_faa_segment_t* next = atomic_load(&head->next);
+            if (next == NULL) break;
+
+            fifo_faa_segment_t* lagging = head;
+            atomic_compare_exchange_strong(&queue->tail, &lagging, next); //tail must never point at a retired segment
+            if (atomic_compare_exchange_strong(&queue->head, &head, next)) fifoEpochRetire(head, faaSegmentRelease);
+            continue;
+        } //segment drained: move on to the next one
+
+        data = atomic_exchange(&head->items[idx], FAA_TAKEN);
+        if (data != NULL) break;
+        //producer claimed the cell but has not filled it yet; it will retry elsewhere
+    }
+    fifoEpochExit();
+    
+    return data;
+}
+
+int fifoFaaPush(fifo_buffer_t* buffer, void* data) 
+{
+    if (data == NULL) return EINVAL;
+
+    int status = faaEnqueue(buffer->impl.faa, data);
+    if (status == 0) fifoCondNotify(&buffer->cond_nonempty);
+    return status;
+}
+
+void* fifoFaaPull(fifo_buffer_t* buffer, bool blocking) 
+{
+    void* data = faaDequeue(buffer->impl.faa);
+
+    while (data == NULL && blocking) 
+    {
+        unsigned seq = fifoCondEnterWait(&buffer->cond_nonempty);
+        data = faaDequeue(buffer->impl.faa);
+        if (data == NULL) fifoFutexWait(&buffer->cond_nonempty.seq, seq);
+        fifoCondLeaveWait(&buffer->cond_nonempty);
+    } //recheck after announcing ourselves so a concurrent push cannot be missed
+    
+    return data;
+}
+
+void** fifoFaaFlush(fifo_buffer_t* buffer) 
+{
+    int capacity = 16, count = 0;
+    void** out = (void**) malloc(capacity * sizeof(void*));
+    if (out == NULL) return NULL;
+    
+    while (true) 
+    {
+        if (count + 1 == capacity) 
+        {
+            void** grown = (void**) realloc(out, 2 * capacity * sizeof(void*));
+            if (grown == NULL) break; //keep what fits; remaining data stays queued
+            out = grown;
+            capacity *= 2;
+        } //before dequeuing, so an item is never taken without room for it
+        void* data = faaDequeue(buffer->impl.faa);
+        if (data == NULL) break;
+        out[count++] = data;
+    }
+    out[count] = NULL;
+    return out;
+}
+
+int fifoFaaSnapshot(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries, int* occupancy) 
+{
+    int count = 0, total = 0;
+
+    fifoEpochEnter();
+    for (fifo_faa_segment_t* segment = atomic_load(&buffer->impl.faa->head); segment != NULL; segment = atomic_load(&segment->next)) 
+    {
+        int first = atomic_load(&segment->deqidx);
+        int last = atomic_load(&segment->enqidx);
+        if (last > FIFO_FAA_SEGMENT_SIZE) last = FIFO_FAA_SEGMENT_SIZE;
+        
+        for (int idx = first; idx < last; idx++) 
+        {
+            void* data = atomic_load_explicit(&segment->items[idx], memory_order_acquire);
+            if (data == NULL || data == FAA_TAKEN) continue;
+            if (count < max_entries) 
+            {
+                entries[count].position = count;
+                entries[count].priority = 0;
+                entries[count].age_ns = 0;
+                entries[count].data = data;
+                count++;
+            }
+            total++;
+        }
+    } //racy but safe walk: segments cannot be freed while we are inside the epoch
+    fifoEpochExit();
+    
+    *occupancy = total;
+    return count;
+}
@@ -0,0 +1,92 @@
+/**
+ * Description: Declarations shared between the translation units of the FIFO library.
+ *  Nothing in this header is part of the public API.
+ **/
+
+#ifndef _FIFO_INTERNAL_H_
+#define _FIFO_INTERNAL_H_
+
+    #include "fifo.h"
+
+    //Number of buffers the registry can track at once. Buffers created while the
+    //registry is full still work but are omitted from fifoRegistryDump
+    #ifndef FIFO_REGISTRY_SIZE
+    #define FIFO_REGISTRY_SIZE 256
+    #endif
+
+    //Publishes buffer in the registry. Returns the slot index or -1 if the registry is full
+    int fifoRegistryAdd(fifo_buffer_t* buffer);
+
+    //Removes buffer from the registry and waits for in-progress dumps to drop their reference
+    void fifoRegistryRemove(fifo_buffer_t* buffer);
+
+    //Takes the buffer lock, waiting for it only if blocking. Returns 0 or the locking error, see fifo.c
+    int fifoLockBuffer(fifo_buffer_t* buffer, bool blocking);
+
+    //Monotonic clock in nanoseconds for aging queued nodes, see fifo.c. Returns 0 without FIFO_ENABLE_STATS
+    uint64_t fifoNowNs(void);
+
+    //FIFO_BACKEND_FAA, see fifo_faa.c
+    struct FaaQueue* fifoFaaCreate(void);
+    void fifoFaaDestroy(struct FaaQueue* queue);
+    int fifoFaaPush(fifo_buffer_t* buffer, void* data);
+    void* fifoFaaPull(fifo_buffer_t* buffer, bool blocking);
+    void** fifoFaaFlush(fifo_buffer_t* buffer);
+    int fifoFaaSnapshot(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries, int* occupancy);
+
+    //FIFO_BACKEND_MULTIQUEUE, see fifo_multiqueue.c
+    struct MultiQueue* fifoMqCreate(int threads);
+    void fifoMqDestroy(struct MultiQueue* mq);
+    int fifoMqPush(fifo_buffer_t* buffer, void* data, int priority, bool blocking);
+    void* fifoMqPull(fifo_buffer_t* buffer, bool blocking);
+    void** fifoMqFlush(fifo_buffer_t* buffer);
+    int fifoMqSnapshot(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries);
+    void fifoMqStats(fifo_buffer_t* buffer, fifo_stats_t* stats);
+
+    //FIFO_BACKEND_SKIPLIST, see fifo_skiplist.c
+    struct SkipList* fifoSkipCreate(void);
+    void fifoSkipDestroy(struct SkipList* list);
+    int fifoSkipPush(fifo_buffer_t* buffer, void* data, int priority, bool blocking);
+    void* fifoSkipPull(fifo_buffer_t* buffer, bool blocking);
+    void** fifoSkipFlush(fifo_buffer_t* buffer);
+    int fifoSkipSnapshot(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries, int* occupancy);
+
+    //FIFO_BACKEND_RADIX, see fifo_radix.c. Uses the buffer lock and conditions
+    struct RadixHeap* fifoRadixCreate(void);
+    void fifoRadixDestroy(struct RadixHeap* heap);
+    int fifoRadixPush(fifo_buffer_t* buffer, void* data, uint64_t key, bool at_last, bool blocking);
+    void* fifoRadixPull(fifo_buffer_t* buffer, bool blocking);
+    void** fifoRadixFlush(fifo_buffer_t* buffer, bool blocking);
+    int fifoRadixSnapshotLocked(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries, uint64_t now);
+
+    //FIFO_BACKEND_CALENDAR, see fifo_calendar.c. Uses the buffer lock and conditions
+    struct Calendar* fifoCalCreate(void);
+    void fifoCalDestroy(struct Calendar* cal);
+    int fifoCalPush(fifo_buffer_t* buffer, void* data, uint64_t key, bool at_last, bool blocking);
+    void* fifoCalPull(fifo_buffer_t* buffer, bool blocking);
+    void** fifoCalFlush(fifo_buffer_t* buffer, bool blocking);
+    int fifoCalSnapshotLocked(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries, uint64_t now);
+
+    //Signal-safe push ring, see fifo_signal.c
+    struct SignalRing* fifoSignalRingCreate(int capacity, bool use_eventfd);
+    void fifoSignalRingDestroy(struct SignalRing* ring);
+    bool fifoSignalRingPop(struct SignalRing* ring, void** data, int* priority);
+    int fifoSignalRingCount(struct SignalRing* ring);
+
+    //fifoPushUnique key index, see fifo_dedup.c. Callers hold the buffer lock
+    struct DedupIndex* fifoDedupCreate(const fifo_attr_t* attr, int capacity);
+    void fifoDedupDestroy(struct DedupIndex* index);
+    bool fifoDedupFind(struct DedupIndex* index, uint64_t key, fifo_node_t** node);
+    void fifoDedupMerge(struct DedupIndex* index, fifo_node_t* node, void* data);
+    void fifoDedupInsert(struct DedupIndex* index, uint64_t key, fifo_node_t* node);
+    void fifoDedupRemove(struct DedupIndex* index, uint64_t key);
+    void fifoDedupClear(struct DedupIndex* index);
+
+    //FIFO_BACKEND_STACK, see fifo_stack.c
+    struct Stack* fifoStackCreate(void);
+    void fifoStackDestroy(struct Stack* stack);
+    int fifoStackPush(fifo_buffer_t* buffer, void* data, bool blocking);
+    void* fifoStackPull(fifo_buffer_t* buffer, bool blocking);
+    void** fifoStackFlush(fifo_buffer_t* buffer);
+    int fifoStackSnapshot(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries, int* occupancy);
+#endif
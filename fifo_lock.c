@@ -0,0 +1,556 @@
+/**
+ * Description: Lock strategies and futex-based condition for FIFO buffers. See fifo_lock.h
+ **/
+#define _GNU_SOURCE
+#include "fifo_lock.h"
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+//Number of busy-wait iterations before a SPIN lock goes to sleep in the kernel
+#ifndef FIFO_SPIN_LIMIT
+#define FIFO_SPIN_LIMIT 100
+#endif
+
+//Maximum number of MCS/COHORT locks one thread may hold at the same time
+#ifndef FIFO_MCS_MAX_NEST
+#define FIFO_MCS_MAX_NEST 8
+#endif
+
+//Consecutive hand-overs within one NUMA node before a COHORT lock is released globally
+#ifndef FIFO_COHORT_PASS_LIMIT
+#define FIFO_COHORT_PASS_LIMIT 64
+#endif
+
+//Upper bound on NUMA nodes tracked by a COHORT lock; higher node ids share local locks
+#ifndef FIFO_COHORT_MAX_NODES
+#define FIFO_COHORT_MAX_NODES 16
+#endif
+
+static inline void fifoCpuRelax(void) 
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static inline void futexWait(atomic_uint* word, unsigned expected) 
+{
+    syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static inline void futexWake(atomic_uint* word, int count) 
+{
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+/////////////////////////////// SPIN: spin-then-futex (Drepper, "Futexes Are Tricky", mutex 3)
+static int spinLockAcquire(fifo_lock_t* lock) 
+{
+    unsigned c = 0;
+    for (int i = 0; i < FIFO_SPIN_LIMIT; i++) 
+    {
+        c = 0;
+        if (atomic_compare_exchange_weak_explicit(&lock->word, &c, 1, memory_order_acquire, memory_order_relaxed)) return 0;
+        fifoCpuRelax();
+    } //uncontended or briefly held: acquire without entering the kernel
+
+    //Mark the lock contended so the holder knows to wake us, then sleep until it is free
+    if (c != 2) c = atomic_exchange_explicit(&lock->word, 2, memory_order_acquire);
+    while (c != 0) 
+    {
+        futexWait(&lock->word, 2);
+        c = atomic_exchange_explicit(&lock->word, 2, memory_order_acquire);
+    }
+    return 0;
+}
+
+static int spinLockRelease(fifo_lock_t* lock) 
+{
+    if (atomic_fetch_sub_explicit(&lock->word, 1, memory_order_release) != 1) 
+    {
+        atomic_store_explicit(&lock->word, 0, memory_order_release);
+        futexWake(&lock->word, 1);
+    } //there were sleepers: fully release and wake one
+    return 0;
+}
+
+/////////////////////////////// TICKET
+static int ticketAcquire(fifo_ticket_t* ticket_lock) 
+{
+    unsigned ticket = atomic_fetch_add_explicit(&ticket_lock->next, 1, memory_order_relaxed);
+    int spins = 0;
+    while (atomic_load_explicit(&ticket_lock->serving, memory_order_acquire) != ticket) 
+    {
+        if (++spins < FIFO_SPIN_LIMIT) fifoCpuRelax();
+        else sched_yield(); //holder may be descheduled; give it the CPU
+    }
+    return 0;
+}
+
+static int ticketTryAcquire(fifo_ticket_t* ticket_lock) 
+{
+    unsigned serving = atomic_load_explicit(&ticket_lock->serving, memory_order_relaxed);
+    unsigned expected = serving;
+    if (atomic_compare_exchange_strong_explicit(&ticket_lock->next, &expected, serving + 1, memory_order_acquire, memory_order_relaxed)) return 0;
+    return EBUSY;
+}
+
+static int ticketRelease(fifo_ticket_t* ticket_lock) 
+{
+    unsigned serving = atomic_load_explicit(&ticket_lock->serving, memory_order_relaxed);
+    atomic_store_explicit(&ticket_lock->serving, serving + 1, memory_order_release);
+    return 0;
+}
+
+//True if threads other than the holder are queued. Only meaningful while held
+static bool ticketHasWaiters(fifo_ticket_t* ticket_lock) 
+{
+    return atomic_load_explicit(&ticket_lock->next, memory_order_relaxed)
+         - atomic_load_explicit(&ticket_lock->serving, memory_order_relaxed) > 1;
+}
+
+/////////////////////////////// MCS (Mellor-Crummey & Scott)
+static __thread fifo_mcs_node_t mcs_nodes[FIFO_MCS_MAX_NEST];
+static __thread int mcs_depth;
+
+static fifo_mcs_node_t* mcsNodeGet(void) 
+{
+    if (mcs_depth >= FIFO_MCS_MAX_NEST) return NULL;
+    fifo_mcs_node_t* node = &mcs_nodes[mcs_depth++];
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    atomic_store_explicit(&node->locked, 1, memory_order_relaxed);
+    return node;
+}
+
+static int mcsAcquire(fifo_lock_t* lock) 
+{
+    fifo_mcs_node_t* node = mcsNodeGet();
+    if (node == NULL) return EDEADLK; //nesting limit exceeded
+
+    fifo_mcs_node_t* prev = atomic_exchange_explicit(&lock->mcs.tail, node, memory_order_acq_rel);
+    if (prev != NULL) 
+    {
+        atomic_store_explicit(&prev->next, node, memory_order_release);
+        int spins = 0;
+        while (atomic_load_explicit(&node->locked, memory_order_acquire)) 
+        {
+            if (++spins < FIFO_SPIN_LIMIT) fifoCpuRelax();
+            else sched_yield();
+        } //spin on our own node only; the predecessor clears it on release
+    } //queue was non-empty: link behind predecessor and wait
+
+    lock->mcs.holder = node;
+    return 0;
+}
+
+static int mcsTryAcquire(fifo_lock_t* lock) 
+{
+    fifo_mcs_node_t* node = mcsNodeGet();
+    if (node == NULL) return EDEADLK;
+
+    fifo_mcs_node_t* expected = NULL;
+    if (atomic_compare_exchange_strong_explicit(&lock->mcs.tail, &expected, node, memory_order_acquire, memory_order_relaxed)) 
+    {
+        lock->mcs.holder = node;
+        return 0;
+    }
+    
+    mcs_depth--;
+    return EBUSY;
+}
+
+static int mcsRelease(fifo_lock_t* lock) 
+{
+    fifo_mcs_node_t* node = lock->mcs.holder;
+    fifo_mcs_node_t* next = atomic_load_explicit(&node->next, memory_order_acquire);
+    
+    if (next == NULL) 
+    {
+        fifo_mcs_node_t* expected = node;
+        if (atomic_compare_exchange_strong_explicit(&lock->mcs.tail, &expected, NULL, memory_order_release, memory_order_relaxed)) 
+        {
+            mcs_depth--;
+            return 0;
+        } //no successor: lock is now free
+        
+        while ((next = atomic_load_explicit(&node->next, memory_order_acquire)) == NULL) fifoCpuRelax();
+    } //a successor swapped itself onto the tail but has not linked in yet
+
+    atomic_store_explicit(&next->locked, 0, memory_order_release);
+    mcs_depth--;
+    return 0;
+}
+
+/////////////////////////////// COHORT (Dice, Marathe & Shavit, C-TKT-TKT)
+typedef struct LocalLock {
+    fifo_ticket_t ticket;
+    bool global_owned;      //set when the previous holder passed the global lock within this node
+    int pass_count;         //consecutive local hand-overs
+} __attribute__((aligned(64))) fifo_cohort_local_t;
+
+typedef struct CohortLock {
+    fifo_ticket_t global __attribute__((aligned(64)));
+    int holder_node;                //node whose local lock the owner holds; written only by the owner
+    int num_nodes;
+    fifo_cohort_local_t local[];
+} fifo_cohort_t;
+
+//Number of NUMA nodes from sysfs ("0-3" style list of possible nodes); 1 if unknown
+static int cohortNodeCount(void) 
+{
+    int first = 0, last = 0;
+    FILE* f = fopen("/sys/devices/system/node/possible", "r");
+    if (f != NULL) 
+    {
+        if (fscanf(f, "%d-%d", &first, &last) < 2) last = first;
+        fclose(f);
+    }
+    
+    int count = last + 1;
+    if (count < 1) count = 1;
+    if (count > FIFO_COHORT_MAX_NODES) count = FIFO_COHORT_MAX_NODES;
+    return count;
+}
+
+static int cohortCurrentNode(fifo_cohort_t* cohort) 
+{
+    unsigned cpu, node = 0;
+    if (cohort->num_nodes > 1 && getcpu(&cpu, &node) != 0) node = 0;
+    return node % cohort->num_nodes;
+}
+
+static int cohortInit(fifo_lock_t* lock) 
+{
+    int num_nodes = cohortNodeCount();
+    fifo_cohort_t* cohort = NULL;
+    if (posix_memalign((void**) &cohort, 64, sizeof(fifo_cohort_t) + num_nodes * sizeof(fifo_cohort_local_t)) != 0) return ENOMEM;
+    
+    atomic_init(&cohort->global.next, 0);
+    atomic_init(&cohort->global.serving, 0);
+    cohort->holder_node = 0;
+    cohort->num_nodes = num_nodes;
+    for (int i = 0; i < num_nodes; i++) 
+    {
+        atomic_init(&cohort->local[i].ticket.next, 0);
+        atomic_init(&cohort->local[i].ticket.serving, 0);
+        cohort->local[i].global_owned = false;
+        cohort->local[i].pass_count = 0;
+    }
+    
+    lock->cohort = cohort;
+    return 0;
+}
+
+static int cohortAcquire(fifo_lock_t* lock) 
+{
+    fifo_cohort_t* cohort = lock->cohort;
+    int node = cohortCurrentNode(cohort);
+    fifo_cohort_local_t* local = &cohort->local[node];
+
+    ticketAcquire(&local->ticket);
+    if (!local->global_owned) ticketAcquire(&cohort->global); //not inherited from a same-node holder
+    
+    cohort->holder_node = node;
+    return 0;
+}
+
+static int cohortTryAcquire(fifo_lock_t* lock) 
+{
+    fifo_cohort_t* cohort = lock->cohort;
+    int node = cohortCurrentNode(cohort);
+    fifo_cohort_local_t* local = &cohort->local[node];
+
+    if (ticketTryAcquire(&local->ticket) != 0) return EBUSY;
+    if (!local->global_owned && ticketTryAcquire(&cohort->global) != 0) 
+    {
+        ticketRelease(&local->ticket);
+        return EBUSY;
+    }
+    
+    cohort->holder_node = node;
+    return 0;
+}
+
+static int cohortRelease(fifo_lock_t* lock) 
+{
+    fifo_cohort_t* cohort = lock->cohort;
+    fifo_cohort_local_t* local = &cohort->local[cohort->holder_node];
+
+    if (ticketHasWaiters(&local->ticket) && local->pass_count < FIFO_COHORT_PASS_LIMIT) 
+    {
+        local->global_owned = true;
+        local->pass_count++;
+    } //keep the global lock within this node; the next local waiter inherits it
+    else 
+    {
+        local->global_owned = false;
+        local->pass_count = 0;
+        ticketRelease(&cohort->global);
+    } //no local waiters, or the node has had its turn: let other nodes in
+    
+    return ticketRelease(&local->ticket);
+}
+
+/////////////////////////////// Unsynchronized
+//Only ownership bookkeeping, and only in debug builds: a release build compiles to nothing
+static int unsyncAcquire(fifo_lock_t* lock) 
+{
+#ifndef NDEBUG
+    if (!lock->none.bound) 
+    {
+        lock->none.owner = pthread_self();
+        lock->none.bound = true;
+    } //bound on first use, so a buffer may be created on one thread and handed to another
+    assert(pthread_equal(lock->none.owner, pthread_self()) && "FIFO_LOCK_NONE buffer used from a second thread");
+    assert(!lock->none.held && "FIFO_LOCK_NONE buffer re-entered, e.g. from a signal handler");
+    lock->none.held = true;
+#else
+    (void) lock;
+#endif
+    return 0;
+}
+
+static int unsyncRelease(fifo_lock_t* lock) 
+{
+#ifndef NDEBUG
+    assert(lock->none.held && pthread_equal(lock->none.owner, pthread_self()));
+    lock->none.held = false;
+#else
+    (void) lock;
+#endif
+    return 0;
+}
+
+/////////////////////////////// Dispatch
+int fifoLockInit(fifo_lock_t* lock, fifo_lock_kind_t kind) 
+{
+    lock->kind = kind;
+    
+    switch (kind) 
+    {
+        case FIFO_LOCK_NONE:
+            lock->none.bound = false;
+            lock->none.held = false;
+            return 0;
+        case FIFO_LOCK_SPIN:
+            atomic_init(&lock->word, 0);
+            return 0;
+        case FIFO_LOCK_TICKET:
+            atomic_init(&lock->ticket.next, 0);
+            atomic_init(&lock->ticket.serving, 0);
+            return 0;
+        case FIFO_LOCK_MCS:
+            atomic_init(&lock->mcs.tail, NULL);
+            lock->mcs.holder = NULL;
+            return 0;
+        case FIFO_LOCK_COHORT:
+            return cohortInit(lock);
+        default:
+            break;
+    }
+
+    pthread_mutexattr_t mutex_attr;
+    pthread_mutexattr_init(&mutex_attr);
+    switch (kind) 
+    {
+        case FIFO_LOCK_NORMAL:
+            pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_NORMAL);
+            break;
+        case FIFO_LOCK_ADAPTIVE:
+#ifdef PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP
+            pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_ADAPTIVE_NP);
+#else
+            pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_NORMAL); //adaptive type unavailable
+#endif
+            break;
+        case FIFO_LOCK_PI:
+            pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_NORMAL);
+            if (pthread_mutexattr_setprotocol(&mutex_attr, PTHREAD_PRIO_INHERIT) != 0) 
+            {
+                pthread_mutexattr_destroy(&mutex_attr);
+                return ENOTSUP;
+            }
+            break;
+        default:
+            lock->kind = FIFO_LOCK_ERRORCHECK;
+            pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_ERRORCHECK);
+            break;
+    }
+    int status = pthread_mutex_init(&lock->mutex, &mutex_attr);
+    pthread_mutexattr_destroy(&mutex_attr);
+    return status;
+}
+
+int fifoLockDestroy(fifo_lock_t* lock) 
+{
+    switch (lock->kind) 
+    {
+        case FIFO_LOCK_SPIN:
+        case FIFO_LOCK_TICKET:
+        case FIFO_LOCK_MCS:
+        case FIFO_LOCK_NONE:
+            return 0;
+        case FIFO_LOCK_COHORT:
+            free(lock->cohort);
+            return 0;
+        default:
+            return pthread_mutex_destroy(&lock->mutex);
+    }
+}
+
+int fifoLockAcquire(fifo_lock_t* lock) 
+{
+    switch (lock->kind) 
+    {
+        case FIFO_LOCK_SPIN: return spinLockAcquire(lock);
+        case FIFO_LOCK_TICKET: return ticketAcquire(&lock->ticket);
+        case FIFO_LOCK_MCS: return mcsAcquire(lock);
+        case FIFO_LOCK_COHORT: return cohortAcquire(lock);
+        case FIFO_LOCK_NONE: return unsyncAcquire(lock);
+        default: return pthread_mutex_lock(&lock->mutex);
+    }
+}
+
+int fifoLockTryAcquire(fifo_lock_t* lock) 
+{
+    unsigned expected = 0;
+    switch (lock->kind) 
+    {
+        case FIFO_LOCK_SPIN:
+            if (atomic_compare_exchange_strong_explicit(&lock->word, &expected, 1, memory_order_acquire, memory_order_relaxed)) return 0;
+            return EBUSY;
+        case FIFO_LOCK_TICKET: return ticketTryAcquire(&lock->ticket);
+        case FIFO_LOCK_MCS: return mcsTryAcquire(lock);
+        case FIFO_LOCK_COHORT: return cohortTryAcquire(lock);
+        case FIFO_LOCK_NONE: return unsyncAcquire(lock);
+        default: return pthread_mutex_trylock(&lock->mutex);
+    }
+}
+
+int fifoLockRelease(fifo_lock_t* lock) 
+{
+    switch (lock->kind) 
+    {
+        case FIFO_LOCK_SPIN: return spinLockRelease(lock);
+        case FIFO_LOCK_TICKET: return ticketRelease(&lock->ticket);
+        case FIFO_LOCK_MCS: return mcsRelease(lock);
+        case FIFO_LOCK_COHORT: return cohortRelease(lock);
+        case FIFO_LOCK_NONE: return unsyncRelease(lock);
+        default: return pthread_mutex_unlock(&lock->mutex);
+    }
+}
+
+const char* fifoLockKindName(fifo_lock_kind_t kind) 
+{
+    switch (kind) 
+    {
+        case FIFO_LOCK_ERRORCHECK: return "errorcheck";
+        case FIFO_LOCK_NORMAL: return "normal";
+        case FIFO_LOCK_ADAPTIVE: return "adaptive";
+        case FIFO_LOCK_SPIN: return "spin";
+        case FIFO_LOCK_TICKET: return "ticket";
+        case FIFO_LOCK_MCS: return "mcs";
+        case FIFO_LOCK_COHORT: return "cohort";
+        case FIFO_LOCK_PI: return "pi";
+        case FIFO_LOCK_NONE: return "none";
+        default: return "unknown";
+    }
+}
+
+void fifoFutexWait(atomic_uint* word, unsigned expected) 
+{
+    futexWait(word, expected);
+}
+
+void fifoFutexWake(atomic_uint* word, int count) 
+{
+    futexWake(word, count);
+}
+
+/////////////////////////////// Condition
+void fifoCondInit(fifo_cond_t* cond) 
+{
+    atomic_init(&cond->seq, 0);
+    atomic_init(&cond->waiters, 0);
+    cond->local = false;
+}
+
+void fifoCondBind(fifo_cond_t* cond, const fifo_lock_t* lock) 
+{
+    cond->local = lock->kind == FIFO_LOCK_NONE;
+}
+
+unsigned fifoCondPrepare(fifo_cond_t* cond) 
+{
+    return atomic_load(&cond->seq);
+}
+
+int fifoCondWait(fifo_cond_t* cond, fifo_lock_t* lock, unsigned seq) 
+{
+    if (lock->kind == FIFO_LOCK_NONE) 
+    {
+        unsyncRelease(lock);
+        return EDEADLK;
+    } //the only thread that could satisfy the predicate is this one
+
+    //waiters is raised before the sleep; a signaller that misses it has already bumped seq,
+    //so the futex wait below returns immediately instead of sleeping
+    atomic_fetch_add(&cond->waiters, 1);
+    int status = fifoLockRelease(lock);
+    if (status != 0) 
+    {
+        atomic_fetch_sub(&cond->waiters, 1);
+        return status;
+    }
+    
+    futexWait(&cond->seq, seq);
+    atomic_fetch_sub(&cond->waiters, 1);
+    
+    return fifoLockAcquire(lock);
+}
+
+void fifoCondSignal(fifo_cond_t* cond) 
+{
+    if (cond->local) return;
+    atomic_fetch_add(&cond->seq, 1);
+    if (atomic_load(&cond->waiters) != 0) futexWake(&cond->seq, 1);
+}
+
+void fifoCondBroadcast(fifo_cond_t* cond) 
+{
+    if (cond->local) return;
+    atomic_fetch_add(&cond->seq, 1);
+    if (atomic_load(&cond->waiters) != 0) futexWake(&cond->seq, INT_MAX);
+}
+
+unsigned fifoCondEnterWait(fifo_cond_t* cond) 
+{
+    atomic_fetch_add(&cond->waiters, 1);
+    unsigned seq = atomic_load(&cond->seq);
+    atomic_thread_fence(memory_order_seq_cst); //waiters must be visible before the predicate re-check
+    return seq;
+}
+
+void fifoCondLeaveWait(fifo_cond_t* cond) 
+{
+    atomic_fetch_sub(&cond->waiters, 1);
+}
+
+void fifoCondNotify(fifo_cond_t* cond) 
+{
+    atomic_thread_fence(memory_order_seq_cst); //published data must be visible before waiters is read
+    if (atomic_load_explicit(&cond->waiters, memory_order_relaxed) != 0) 
+    {
+        atomic_fetch_add(&cond->seq, 1);
+        futexWake(&cond->seq, 1);
+    }
+}
@@ -0,0 +1,127 @@
+/**
+ * Description: Lock and condition primitives guarding a FIFO buffer.
+ *  A fifo_lock_t wraps one of several lock strategies selected at initialization:
+ *   FIFO_LOCK_ERRORCHECK  pthread mutex with owner tracking; catches misuse, slowest
+ *   FIFO_LOCK_NORMAL      plain pthread mutex
+ *   FIFO_LOCK_ADAPTIVE    pthread adaptive mutex (spins briefly before sleeping)
+ *   FIFO_LOCK_SPIN        spin-then-futex lock; no pthread bookkeeping at all
+ *   FIFO_LOCK_TICKET      ticket lock; strict FIFO hand-over under heavy contention
+ *   FIFO_LOCK_MCS         MCS queue lock; FIFO hand-over, each waiter spins on its own cache line
+ *   FIFO_LOCK_COHORT      NUMA cohort lock; hands the lock to waiters on the same node first
+ *   FIFO_LOCK_PI          pthread mutex with PTHREAD_PRIO_INHERIT; the holder runs at the
+ *                         priority of its highest-priority waiter, preventing priority inversion
+ *   FIFO_LOCK_NONE        no synchronization at all, for buffers used by a single thread (e.g.
+ *                         deferred work inside an event loop). Acquire and release are no-ops;
+ *                         debug builds assert that every call comes from the first thread to
+ *                         lock and that the lock is not re-entered. Conditions bound to it with
+ *                         fifoCondBind never signal, and waiting fails with EDEADLK, since no
+ *                         other thread could ever change the predicate
+ *
+ *  MCS and COHORT queue nodes live in thread-local storage. A thread may hold at most
+ *  FIFO_MCS_MAX_NEST queue locks at once and must release them in reverse acquisition order.
+ *
+ *  fifo_cond_t is a futex-based condition usable with every lock kind. Waiters take a
+ *  sequence snapshot with fifoCondPrepare before releasing the lock; any signal issued
+ *  after the snapshot wakes them, so no wake-up can be lost between check and sleep.
+ *  As with pthread conditions, wake-ups may be spurious and callers must re-check.
+ **/
+
+#ifndef _FIFO_LOCK_H_
+#define _FIFO_LOCK_H_
+
+    #include <pthread.h>
+    #include <stdatomic.h>
+    #include <stdbool.h>
+
+    typedef enum LockKind {
+        FIFO_LOCK_ERRORCHECK,
+        FIFO_LOCK_NORMAL,
+        FIFO_LOCK_ADAPTIVE,
+        FIFO_LOCK_SPIN,
+        FIFO_LOCK_TICKET,
+        FIFO_LOCK_MCS,
+        FIFO_LOCK_COHORT,
+        FIFO_LOCK_PI,
+        FIFO_LOCK_NONE
+    } fifo_lock_kind_t;
+
+    typedef struct TicketLock {
+        atomic_uint next;           //next ticket to hand out
+        atomic_uint serving;        //ticket currently allowed in
+    } fifo_ticket_t;
+
+    //MCS queue node. One per waiting thread, aligned so waiters never share a cache line
+    typedef struct McsNode {
+        _Atomic(struct McsNode*) next;
+        atomic_int locked;
+    } __attribute__((aligned(64))) fifo_mcs_node_t;
+
+    struct CohortLock; //defined in fifo_lock.c
+
+    typedef struct Lock {
+        fifo_lock_kind_t kind;
+        union {
+            pthread_mutex_t mutex;          //ERRORCHECK, NORMAL, ADAPTIVE, PI
+            atomic_uint word;               //SPIN: 0 unlocked, 1 locked, 2 locked with sleepers
+            fifo_ticket_t ticket;           //TICKET
+            struct {
+                _Atomic(fifo_mcs_node_t*) tail;
+                fifo_mcs_node_t* holder;    //queue node of the current owner; written only by the owner
+            } mcs;                          //MCS
+            struct CohortLock* cohort;      //COHORT: per-node local locks plus a global lock
+            struct {
+                pthread_t owner;            //first thread to acquire; checked only without NDEBUG
+                bool bound;
+                bool held;
+            } none;                         //NONE
+        };
+    } fifo_lock_t;
+
+    typedef struct Cond {
+        atomic_uint seq;        //bumped by every signal; futex word
+        atomic_uint waiters;    //threads inside fifoCondWait; lets signal skip the syscall
+        bool local;             //bound to a FIFO_LOCK_NONE lock: signals are no-ops
+    } fifo_cond_t;
+
+    //Lock interface. All functions return 0 on success; fifoLockTryAcquire returns EBUSY
+    //if the lock is held. The pthread kinds may also return their usual error codes.
+    int fifoLockInit(fifo_lock_t* lock, fifo_lock_kind_t kind);
+    int fifoLockDestroy(fifo_lock_t* lock);
+    int fifoLockAcquire(fifo_lock_t* lock);
+    int fifoLockTryAcquire(fifo_lock_t* lock);
+    int fifoLockRelease(fifo_lock_t* lock);
+
+    //Returns a human readable name for a lock kind
+    const char* fifoLockKindName(fifo_lock_kind_t kind);
+
+    //Futex primitives on a 32-bit word: sleep while *word == expected / wake up to count sleepers
+    void fifoFutexWait(atomic_uint* word, unsigned expected);
+    void fifoFutexWake(atomic_uint* word, int count);
+
+    //Condition interface
+    void fifoCondInit(fifo_cond_t* cond);
+
+    //Declares that cond is only ever waited on with lock. Required for FIFO_LOCK_NONE, where it
+    //turns signals into no-ops; has no effect for the other kinds
+    void fifoCondBind(fifo_cond_t* cond, const fifo_lock_t* lock);
+
+    //Takes the sequence snapshot to pass to fifoCondWait. Call while holding the lock,
+    //before (or while) checking the predicate being waited on.
+    unsigned fifoCondPrepare(fifo_cond_t* cond);
+
+    //Releases lock, sleeps until cond is signalled after snapshot seq, then re-acquires lock.
+    //With FIFO_LOCK_NONE it releases lock and returns EDEADLK without waiting
+    int fifoCondWait(fifo_cond_t* cond, fifo_lock_t* lock, unsigned seq);
+
+    //Waiting without a lock, for the lock-free backends. A waiter calls fifoCondEnterWait, re-checks
+    //its predicate, sleeps with fifoFutexWait(&cond->seq, seq) only if it is still unmet, then calls
+    //fifoCondLeaveWait. Producers call fifoCondNotify after publishing; it is a fence and one load
+    //when nobody waits. The fences on both sides guarantee one of them sees the other.
+    unsigned fifoCondEnterWait(fifo_cond_t* cond);
+    void fifoCondLeaveWait(fifo_cond_t* cond);
+    void fifoCondNotify(fifo_cond_t* cond);
+
+    //Wakes one / all waiters. Safe to call with or without the lock held, and from a signal handler.
+    void fifoCondSignal(fifo_cond_t* cond);
+    void fifoCondBroadcast(fifo_cond_t* cond);
+#endif
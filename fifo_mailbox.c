@@ -0,0 +1,82 @@
+/**
+ * Description: Intrusive MPSC mailbox. See fifo_mailbox.h
+ *  Producers exchange themselves into head and then link the previous head to their node, so
+ *  a push never retries. The consumer walks from tail; the embedded stub is re-pushed whenever
+ *  the last real node would otherwise have to be popped, which keeps head pointing at a node
+ *  the consumer no longer needs.
+ *
+ *  The scheduled flag pairs with the list as a Dekker handshake: a producer links its node and
+ *  then reads the flag, a releasing worker clears the flag and then reads the list, all with
+ *  sequentially consistent operations, so at least one of them sees the other.
+ **/
+#include "fifo_mailbox.h"
+
+static void mailboxLink(fifo_mailbox_t* mailbox, fifo_mailbox_node_t* node) 
+{
+    atomic_store_explicit(&node->next, NULL, memory_order_relaxed);
+    fifo_mailbox_node_t* prev = atomic_exchange(&mailbox->head, node);
+    atomic_store_explicit(&prev->next, node, memory_order_release); //until here the consumer sees a gap after prev
+}
+
+void fifoMailboxInit(fifo_mailbox_t* mailbox) 
+{
+    atomic_init(&mailbox->stub.next, NULL);
+    atomic_init(&mailbox->head, &mailbox->stub);
+    mailbox->tail = &mailbox->stub;
+    atomic_init(&mailbox->state, FIFO_MAILBOX_IDLE);
+}
+
+bool fifoMailboxPush(fifo_mailbox_t* mailbox, fifo_mailbox_node_t* node) 
+{
+    mailboxLink(mailbox, node);
+    if (atomic_load(&mailbox->state) == FIFO_MAILBOX_SCHEDULED) return false; //common case: a plain load
+
+    int expected = FIFO_MAILBOX_IDLE;
+    return atomic_compare_exchange_strong(&mailbox->state, &expected, FIFO_MAILBOX_SCHEDULED);
+}
+
+fifo_mailbox_node_t* fifoMailboxPop(fifo_mailbox_t* mailbox) 
+{
+    fifo_mailbox_node_t* tail = mailbox->tail;
+    fifo_mailbox_node_t* next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (tail == &mailbox->stub) 
+    {
+        if (next == NULL) return NULL;
+        mailbox->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&next->next, memory_order_acquire);
+    } //skip the stub
+
+    if (next != NULL) 
+    {
+        mailbox->tail = next;
+        return tail;
+    }
+
+    if (tail != atomic_load_explicit(&mailbox->head, memory_order_acquire)) return NULL; //a push is linking behind tail
+
+    mailboxLink(mailbox, &mailbox->stub); //tail is the last node: put the stub behind it so it can go
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next != NULL) 
+    {
+        mailbox->tail = next;
+        return tail;
+    }
+    return NULL; //a push slipped in before the stub and has not linked yet
+}
+
+bool fifoMailboxEmpty(fifo_mailbox_t* mailbox) 
+{
+    fifo_mailbox_node_t* tail = mailbox->tail;
+    if (tail != &mailbox->stub) return false; //tail is the next node to pop, so it is still queued
+    return atomic_load(&tail->next) == NULL && atomic_load(&mailbox->head) == tail;
+}
+
+bool fifoMailboxRelease(fifo_mailbox_t* mailbox) 
+{
+    atomic_store(&mailbox->state, FIFO_MAILBOX_IDLE);
+    if (fifoMailboxEmpty(mailbox)) return false;
+
+    int expected = FIFO_MAILBOX_IDLE;
+    return atomic_compare_exchange_strong(&mailbox->state, &expected, FIFO_MAILBOX_SCHEDULED); //lost: a producer scheduled it
+}
@@ -0,0 +1,64 @@
+/**
+ * Description: Compact actor mailbox. A fifo_mailbox_t is 32 bytes with its stub node embedded,
+ *  takes no lock and allocates nothing: messages embed a fifo_mailbox_node_t and are linked
+ *  into an intrusive multi-producer single-consumer list (D. Vyukov's non-intrusive-stub MPSC
+ *  queue). Memory therefore scales with messages in flight, not with the number of mailboxes.
+ *
+ *  A mailbox owns no condition or thread. Instead it carries a scheduled/idle flag and tells
+ *  its caller when it must be handed to a scheduler, such as a fifo_buffer_t run queue:
+ *   1) fifoMailboxPush returns true for the push that finds the mailbox idle; that producer
+ *      schedules the mailbox, exactly once
+ *   2) the worker that runs it pops messages with fifoMailboxPop until it returns NULL or the
+ *      worker's batch is used up
+ *   3) the worker calls fifoMailboxRelease. If it returns true the mailbox is still (or again)
+ *      scheduled and the worker must run or reschedule it; otherwise it is idle and the next
+ *      push schedules it
+ *  So at most one worker runs a mailbox at a time and no message is ever left unscheduled.
+ *
+ *  fifoMailboxPush may be called by any thread. Pop and release belong to the single worker
+ *  currently running the mailbox. Pop may return NULL while a producer is between its two
+ *  steps; fifoMailboxRelease then reports the mailbox as non-empty so the message is not lost.
+ **/
+
+#ifndef _FIFO_MAILBOX_H_
+#define _FIFO_MAILBOX_H_
+
+    #include <stdatomic.h>
+    #include <stdbool.h>
+    #include <stddef.h>
+
+    //Link embedded in every message. Recover the message with fifoMailboxEntry
+    typedef struct MailboxNode {
+        _Atomic(struct MailboxNode*) next;
+    } fifo_mailbox_node_t;
+
+    typedef struct Mailbox {
+        _Atomic(fifo_mailbox_node_t*) head;     //last pushed node; producers exchange here
+        fifo_mailbox_node_t* tail;              //next node to pop; consumer only
+        fifo_mailbox_node_t stub;               //keeps the list non-empty so push is one exchange
+        atomic_int state;                       //FIFO_MAILBOX_IDLE or FIFO_MAILBOX_SCHEDULED
+    } fifo_mailbox_t;
+
+    #define FIFO_MAILBOX_IDLE 0
+    #define FIFO_MAILBOX_SCHEDULED 1
+
+    //Pointer to the struct of type type whose member member is the node pointer node
+    #define fifoMailboxEntry(node, type, member) ((type*) ((char*) (node) - offsetof(type, member)))
+
+    //Initializes an empty, idle mailbox. Mailboxes need no destructor
+    void fifoMailboxInit(fifo_mailbox_t* mailbox);
+
+    //Appends node. Wait-free: one exchange and one store. Returns true if the mailbox was idle
+    //and the caller must now schedule it
+    bool fifoMailboxPush(fifo_mailbox_t* mailbox, fifo_mailbox_node_t* node);
+
+    //Removes the oldest message, or returns NULL if there is none yet. Running worker only
+    fifo_mailbox_node_t* fifoMailboxPop(fifo_mailbox_t* mailbox);
+
+    //Marks the mailbox idle after a run. Returns true if messages arrived meanwhile and the
+    //mailbox was reclaimed for this worker, which must run or reschedule it. Running worker only
+    bool fifoMailboxRelease(fifo_mailbox_t* mailbox);
+
+    //Whether the mailbox holds no message. Exact only for the running worker
+    bool fifoMailboxEmpty(fifo_mailbox_t* mailbox);
+#endif
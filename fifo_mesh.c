@@ -0,0 +1,129 @@
+/**
+ * Description: SPSC ring mesh. See fifo_mesh.h
+ *  Ring ring[to * cores + from] carries messages from core from to core to, so a receiver's
+ *  inbound rings are contiguous. Sender and receiver fields sit on separate cache lines; each
+ *  side writes only its own line and reads the other one only on a cache miss of its view.
+ **/
+#include "fifo_mesh.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+//The slot pointer is not kept here: on the receiver line it would cost the sender a miss per
+//send. Both sides derive it from the read-only fifo_mesh_t instead
+typedef struct MeshRing {
+    //sender line
+    atomic_size_t tail __attribute__((aligned(64)));    //next slot to write
+    size_t head_cache;                                  //sender's last view of head
+    //receiver line
+    atomic_size_t head __attribute__((aligned(64)));    //next slot to read
+    size_t tail_cache;                                  //receiver's last view of tail
+} fifo_mesh_ring_t;
+
+typedef struct Mesh {
+    int cores;
+    size_t mask;
+    fifo_mesh_ring_t* rings;
+    int* sweep_start;           //per receiver, ring the next poll starts at; padded apart
+    void** slots;               //backing store of every ring, mask + 1 slots each in ring order
+} fifo_mesh_t;
+
+#define MESH_SWEEP_STRIDE (64 / sizeof(int)) //one cache line per receiver's sweep index
+
+fifo_mesh_t* fifoMeshCreate(int cores, int ring_capacity) 
+{
+    if (cores <= 0 || ring_capacity <= 0) return NULL;
+    size_t size = 2;
+    while (size < (size_t) ring_capacity) size <<= 1;
+
+    fifo_mesh_t* mesh = (fifo_mesh_t*) malloc(sizeof(fifo_mesh_t));
+    if (mesh == NULL) return NULL;
+    size_t count = (size_t) cores * cores;
+    mesh->cores = cores;
+    mesh->mask = size - 1;
+    mesh->rings = NULL;
+    mesh->sweep_start = NULL;
+    mesh->slots = NULL;
+    if (posix_memalign((void**) &mesh->rings, 64, count * sizeof(fifo_mesh_ring_t)) != 0 ||
+        posix_memalign((void**) &mesh->sweep_start, 64, cores * MESH_SWEEP_STRIDE * sizeof(int)) != 0 ||
+        posix_memalign((void**) &mesh->slots, 64, count * size * sizeof(void*)) != 0) 
+    {
+        fifoMeshDestroy(mesh);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++) 
+    {
+        fifo_mesh_ring_t* ring = &mesh->rings[i];
+        atomic_init(&ring->tail, 0);
+        atomic_init(&ring->head, 0);
+        ring->head_cache = 0;
+        ring->tail_cache = 0;
+    }
+    for (int i = 0; i < cores; i++) mesh->sweep_start[i * MESH_SWEEP_STRIDE] = 0;
+    return mesh;
+}
+
+void fifoMeshDestroy(fifo_mesh_t* mesh) 
+{
+    free(mesh->slots);
+    free(mesh->sweep_start);
+    free(mesh->rings);
+    free(mesh);
+}
+
+int fifoMeshCores(const fifo_mesh_t* mesh) 
+{
+    return mesh->cores;
+}
+
+int fifoMeshSend(fifo_mesh_t* mesh, int from, int to, void* data) 
+{
+    size_t index = (size_t) to * mesh->cores + from;
+    fifo_mesh_ring_t* ring = &mesh->rings[index];
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed); //only this thread writes it
+    if (tail - ring->head_cache > mesh->mask) 
+    {
+        ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->head_cache > mesh->mask) return -1;
+    } //full by the cached view: refresh it once
+
+    mesh->slots[index * (mesh->mask + 1) + (tail & mesh->mask)] = data;
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+int fifoMeshPoll(fifo_mesh_t* mesh, int core, void** out, int* senders, int max_count) 
+{
+    int cores = mesh->cores;
+    fifo_mesh_ring_t* inbound = &mesh->rings[(size_t) core * cores];
+    int* sweep_start = &mesh->sweep_start[core * MESH_SWEEP_STRIDE];
+    int start = *sweep_start;
+    int count = 0;
+
+    for (int k = 0; k < cores && count < max_count; k++) 
+    {
+        int from = start + k < cores ? start + k : start + k - cores;
+        fifo_mesh_ring_t* ring = &inbound[from];
+        void** slots = mesh->slots + ((size_t) core * cores + from) * (mesh->mask + 1);
+        size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed); //only this thread writes it
+        if (head == ring->tail_cache) 
+        {
+            ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+            if (head == ring->tail_cache) continue;
+        } //empty by the cached view: refresh it once
+
+        size_t available = ring->tail_cache - head;
+        if (available > (size_t) (max_count - count)) available = max_count - count;
+        for (size_t i = 0; i < available; i++) 
+        {
+            out[count] = slots[(head + i) & mesh->mask];
+            if (senders != NULL) senders[count] = from;
+            count++;
+        }
+        atomic_store_explicit(&ring->head, head + available, memory_order_release); //one publish per ring
+    }
+
+    *sweep_start = start + 1 < cores ? start + 1 : 0;
+    return count;
+}
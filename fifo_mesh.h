@@ -0,0 +1,41 @@
+/**
+ * Description: Shared-nothing message mesh for thread-per-core designs. A mesh of N cores
+ *  holds N×N single-producer single-consumer rings, one per ordered (sender, receiver) pair,
+ *  so no two threads ever write the same index and cross-core messages need no locked atomic
+ *  instruction: the ring indices are published with plain release stores and read with
+ *  acquire loads. Each side also caches the other side's index and re-reads it only when the
+ *  cached value says the ring is full (sender) or empty (receiver), so a steady stream of
+ *  messages touches the shared cache lines about once per ring-full rather than per message.
+ *
+ *  The rings feeding one receiver are laid out next to each other, and fifoMeshPoll sweeps
+ *  them all in one pass, copying every available message of a ring and publishing the new
+ *  read index once per ring. The sweep starts one ring further on each call so no sender can
+ *  starve the others when the caller's batch is smaller than the backlog.
+ *
+ *  Core numbers are 0..N-1 and are the caller's notion of "core": exactly one thread may send
+ *  as a given core and exactly one may poll as a given core (the two may be the same thread).
+ **/
+
+#ifndef _FIFO_MESH_H_
+#define _FIFO_MESH_H_
+
+    typedef struct Mesh fifo_mesh_t; //defined in fifo_mesh.c
+
+    //Creates a mesh of cores×cores rings, each holding at least ring_capacity messages (rounded
+    //up to a power of two). Returns NULL on failure
+    fifo_mesh_t* fifoMeshCreate(int cores, int ring_capacity);
+
+    //Frees the mesh. Messages still in the rings are dropped; drain them with fifoMeshPoll first
+    void fifoMeshDestroy(fifo_mesh_t* mesh);
+
+    //Sends data from core from to core to. Never blocks: returns 0, or -1 if that ring is full
+    int fifoMeshSend(fifo_mesh_t* mesh, int from, int to, void* data);
+
+    //Receives up to max_count messages for core from all its inbound rings into out, and
+    //optionally stores each message's sender in senders (may be NULL). Returns the count, 0 if
+    //nothing is pending. Messages from one sender arrive in send order
+    int fifoMeshPoll(fifo_mesh_t* mesh, int core, void** out, int* senders, int max_count);
+
+    //Number of cores the mesh was created with
+    int fifoMeshCores(const fifo_mesh_t* mesh);
+#endif
@@ -0,0 +1,360 @@
+/**
+ * Description: Relaxed priority backend (FIFO_BACKEND_MULTIQUEUE), after the MultiQueue of
+ *  Rihani, Sanders & Dementiev. The buffer is split into c x P binary heaps, each with its
+ *  own spin lock and a cached copy of its top priority. A push locks one random heap. A pull
+ *  reads the cached tops of two random heaps and pops from the better one. There is no global
+ *  ordering point, so throughput scales with the thread count, at the price of pulls
+ *  returning an element that is only close to the highest priority.
+ *
+ *  Priority semantics follow the list backend: negative priorities are served first, newest
+ *  first, then higher values before lower ones, ties first-in first-out within one heap.
+ *  Negative pushes draw their rank from a shared counter so newest-first holds across heaps.
+ *
+ *  Rank error is sampled: every FIFO_MQ_RANK_SAMPLE-th pull of a thread counts how many heap
+ *  tops were better than the element it returned. The samples are reported through
+ *  fifoGetStats as rank_error_sum / rank_error_samples / rank_error_max.
+ *
+ *  Two shared counters remain, one for capacity and one for available items, so that
+ *  max_buffer_size and blocking behave as in the other backends.
+ **/
+#include "fifo_internal.h"
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MQ_EMPTY INT64_MIN  //cached top of an empty heap
+
+typedef struct MqEntry {
+    int64_t rank;       //higher is served first; negative priorities map above INT_MAX
+    uint64_t seq;       //per-heap push order for ties
+    void* data;
+    int priority;       //priority as pushed, for snapshots
+} fifo_mq_entry_t;
+
+typedef struct MqHeap {
+    fifo_lock_t lock;
+    _Atomic int64_t top;            //rank of the top entry, read without the lock
+    fifo_mq_entry_t* entries;
+    int count;
+    int capacity;
+    uint64_t next_seq;
+    unsigned long pushes;
+    unsigned long pulls;
+} __attribute__((aligned(64))) fifo_mq_heap_t;
+
+typedef struct MultiQueue {
+    atomic_int reserved __attribute__((aligned(64)));   //slots claimed by pushes, for capacity
+    atomic_int available __attribute__((aligned(64)));  //items pulls may claim
+    atomic_ulong rank_error_sum __attribute__((aligned(64)));
+    atomic_ulong rank_error_samples;
+    atomic_ulong rank_error_max;
+    atomic_long negative_seq;   //negative pushes so far, ranks them newest first
+    int num_heaps;
+    fifo_mq_heap_t heaps[];
+} fifo_mq_t;
+
+static __thread uint64_t mq_rng;
+static __thread unsigned mq_pull_count;
+
+static unsigned mqRandom(void) 
+{
+    if (mq_rng == 0) mq_rng = ((uintptr_t) &mq_rng * 0x9E3779B97F4A7C15ull) | 1;
+    mq_rng ^= mq_rng << 13;
+    mq_rng ^= mq_rng >> 7;
+    mq_rng ^= mq_rng << 17;
+    return (unsigned) (mq_rng >> 32);
+}
+
+static int64_t mqRank(fifo_mq_t* mq, int priority) 
+{
+    return priority < 0 ? (int64_t) INT_MAX + 1 + atomic_fetch_add(&mq->negative_seq, 1) : priority;
+}
+
+static bool mqBetter(const fifo_mq_entry_t* a, const fifo_mq_entry_t* b) 
+{
+    return a->rank > b->rank || (a->rank == b->rank && a->seq < b->seq);
+}
+
+/////////////////////////////// Binary heap, caller holds the heap lock
+static int heapPush(fifo_mq_heap_t* heap, void* data, int priority, int64_t rank) 
+{
+    if (heap->count == heap->capacity) 
+    {
+        int capacity = heap->capacity ? heap->capacity * 2 : 16;
+        fifo_mq_entry_t* entries = (fifo_mq_entry_t*) realloc(heap->entries, capacity * sizeof(fifo_mq_entry_t));
+        if (entries == NULL) return ENOMEM;
+        heap->entries = entries;
+        heap->capacity = capacity;
+    }
+
+    fifo_mq_entry_t entry = {rank, heap->next_seq++, data, priority};
+    int i = heap->count++;
+    while (i > 0 && mqBetter(&entry, &heap->entries[(i - 1) / 2])) 
+    {
+        heap->entries[i] = heap->entries[(i - 1) / 2];
+        i = (i - 1) / 2;
+    } //sift up
+    heap->entries[i] = entry;
+
+    heap->pushes++;
+    atomic_store_explicit(&heap->top, heap->entries[0].rank, memory_order_relaxed);
+    return 0;
+}
+
+static fifo_mq_entry_t heapPop(fifo_mq_heap_t* heap) 
+{
+    fifo_mq_entry_t out = heap->entries[0];
+    fifo_mq_entry_t last = heap->entries[--heap->count];
+    
+    int i = 0;
+    while (true) 
+    {
+        int child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && mqBetter(&heap->entries[child + 1], &heap->entries[child])) child++;
+        if (!mqBetter(&heap->entries[child], &last)) break;
+        heap->entries[i] = heap->entries[child];
+        i = child;
+    } //sift down
+    if (heap->count > 0) heap->entries[i] = last;
+
+    heap->pulls++;
+    atomic_store_explicit(&heap->top, heap->count > 0 ? heap->entries[0].rank : MQ_EMPTY, memory_order_relaxed);
+    return out;
+}
+
+/////////////////////////////// Backend
+struct MultiQueue* fifoMqCreate(int threads) 
+{
+    if (threads <= 0) threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads <= 0) threads = 1;
+    int num_heaps = FIFO_MQ_FACTOR * threads;
+
+    fifo_mq_t* mq = NULL;
+    if (posix_memalign((void**) &mq, 64, sizeof(fifo_mq_t) + num_heaps * sizeof(fifo_mq_heap_t)) != 0) return NULL;
+    
+    atomic_init(&mq->reserved, 0);
+    atomic_init(&mq->available, 0);
+    atomic_init(&mq->rank_error_sum, 0);
+    atomic_init(&mq->rank_error_samples, 0);
+    atomic_init(&mq->rank_error_max, 0);
+    atomic_init(&mq->negative_seq, 0);
+    mq->num_heaps = num_heaps;
+    for (int i = 0; i < num_heaps; i++) 
+    {
+        fifo_mq_heap_t* heap = &mq->heaps[i];
+        fifoLockInit(&heap->lock, FIFO_LOCK_SPIN);
+        atomic_init(&heap->top, MQ_EMPTY);
+        heap->entries = NULL;
+        heap->count = heap->capacity = 0;
+        heap->next_seq = 0;
+        heap->pushes = heap->pulls = 0;
+    }
+    return mq;
+}
+
+void fifoMqDestroy(struct MultiQueue* mq) 
+{
+    for (int i = 0; i < mq->num_heaps; i++) 
+    {
+        fifoLockDestroy(&mq->heaps[i].lock);
+        free(mq->heaps[i].entries);
+    }
+    free(mq);
+}
+
+int fifoMqPush(fifo_buffer_t* buffer, void* data, int priority, bool blocking) 
+{
+    fifo_mq_t* mq = buffer->impl.mq;
+
+    //Claim capacity first so the bound holds however many pushes race
+    while (atomic_fetch_add(&mq->reserved, 1) >= buffer->max_buffer_size) 
+    {
+        atomic_fetch_sub(&mq->reserved, 1);
+        if (!blocking) return -1;
+
+        unsigned seq = fifoCondEnterWait(&buffer->cond_nonfull);
+        if (atomic_load(&mq->reserved) >= buffer->max_buffer_size) fifoFutexWait(&buffer->cond_nonfull.seq, seq);
+        fifoCondLeaveWait(&buffer->cond_nonfull);
+    }
+
+    int64_t rank = mqRank(mq, priority);
+    fifo_mq_heap_t* heap;
+    do heap = &mq->heaps[mqRandom() % mq->num_heaps];
+    while (fifoLockTryAcquire(&heap->lock) != 0); //busy heap: any other one will do
+    
+    int status = heapPush(heap, data, priority, rank);
+    fifoLockRelease(&heap->lock);
+    if (status != 0) 
+    {
+        atomic_fetch_sub(&mq->reserved, 1);
+        fifoCondNotify(&buffer->cond_nonfull); //a pusher may have seen our reservation fill the buffer
+        return status;
+    }
+
+    atomic_fetch_add(&mq->available, 1);
+    fifoCondNotify(&buffer->cond_nonempty);
+    return 0;
+}
+
+//Counts heap tops better than rank; a lower bound on how far the pulled element was from the true top
+static void mqSampleRankError(fifo_mq_t* mq, int64_t rank) 
+{
+    unsigned long error = 0;
+    for (int i = 0; i < mq->num_heaps; i++) 
+    {
+        if (atomic_load_explicit(&mq->heaps[i].top, memory_order_relaxed) > rank) error++;
+    }
+    
+    atomic_fetch_add_explicit(&mq->rank_error_sum, error, memory_order_relaxed);
+    atomic_fetch_add_explicit(&mq->rank_error_samples, 1, memory_order_relaxed);
+    unsigned long max = atomic_load_explicit(&mq->rank_error_max, memory_order_relaxed);
+    while (error > max && !atomic_compare_exchange_weak(&mq->rank_error_max, &max, error));
+}
+
+void* fifoMqPull(fifo_buffer_t* buffer, bool blocking) 
+{
+    fifo_mq_t* mq = buffer->impl.mq;
+
+    //Claim an item; once claimed, one is guaranteed to be in some heap for us
+    int available = atomic_load(&mq->available);
+    while (true) 
+    {
+        if (available > 0) 
+        {
+            if (atomic_compare_exchange_weak(&mq->available, &available, available - 1)) break;
+            continue;
+        }
+        if (!blocking) return NULL;
+
+        unsigned seq = fifoCondEnterWait(&buffer->cond_nonempty);
+        if (atomic_load(&mq->available) <= 0) fifoFutexWait(&buffer->cond_nonempty.seq, seq);
+        fifoCondLeaveWait(&buffer->cond_nonempty);
+        available = atomic_load(&mq->available);
+    }
+
+    fifo_mq_entry_t entry;
+    for (int attempt = 0; ; attempt++) 
+    {
+        fifo_mq_heap_t* heap;
+        if (attempt < 2 * mq->num_heaps) 
+        {
+            fifo_mq_heap_t* a = &mq->heaps[mqRandom() % mq->num_heaps];
+            fifo_mq_heap_t* b = &mq->heaps[mqRandom() % mq->num_heaps];
+            heap = atomic_load_explicit(&a->top, memory_order_relaxed) >= atomic_load_explicit(&b->top, memory_order_relaxed) ? a : b;
+        } //two-choice: the better of two random tops
+        else heap = &mq->heaps[attempt % mq->num_heaps]; //few items left: sweep so the claim is honoured quickly
+
+        if (atomic_load_explicit(&heap->top, memory_order_relaxed) == MQ_EMPTY) continue;
+        if (fifoLockTryAcquire(&heap->lock) != 0) continue;
+        if (heap->count > 0) 
+        {
+            entry = heapPop(heap);
+            fifoLockRelease(&heap->lock);
+            break;
+        }
+        fifoLockRelease(&heap->lock);
+    }
+
+    atomic_fetch_sub(&mq->reserved, 1);
+    fifoCondNotify(&buffer->cond_nonfull);
+
+    if (++mq_pull_count % FIFO_MQ_RANK_SAMPLE == 0) mqSampleRankError(mq, entry.rank);
+    return entry.data;
+}
+
+//qsort order: best first, ties in push order within a heap, as heapPop would return them
+static int mqCompare(const void* a, const void* b) 
+{
+    const fifo_mq_entry_t* x = (const fifo_mq_entry_t*) a;
+    const fifo_mq_entry_t* y = (const fifo_mq_entry_t*) b;
+    if (mqBetter(x, y)) return -1;
+    return mqBetter(y, x) ? 1 : 0;
+}
+
+//Collects elements, best first. With drain_limit < 0 every element is copied; otherwise up to
+//drain_limit elements are removed. Each heap is locked in turn; not atomic across heaps
+static int mqCollect(fifo_mq_t* mq, fifo_mq_entry_t** out, int drain_limit) 
+{
+    int count = 0, capacity = 0;
+    fifo_mq_entry_t* entries = NULL;
+    
+    for (int i = 0; i < mq->num_heaps; i++) 
+    {
+        fifo_mq_heap_t* heap = &mq->heaps[i];
+        fifoLockAcquire(&heap->lock);
+        if (count + heap->count > capacity) 
+        {
+            capacity = 2 * (count + heap->count);
+            fifo_mq_entry_t* grown = (fifo_mq_entry_t*) realloc(entries, capacity * sizeof(fifo_mq_entry_t));
+            if (grown == NULL) 
+            {
+                fifoLockRelease(&heap->lock);
+                break;
+            }
+            entries = grown;
+        }
+        if (drain_limit >= 0) while (heap->count > 0 && count < drain_limit) entries[count++] = heapPop(heap);
+        else for (int j = 0; j < heap->count; j++) entries[count++] = heap->entries[j];
+        fifoLockRelease(&heap->lock);
+    }
+
+    if (count > 1) qsort(entries, count, sizeof(fifo_mq_entry_t), mqCompare); //outside the heap locks
+
+    *out = entries;
+    return count;
+}
+
+void** fifoMqFlush(fifo_buffer_t* buffer) 
+{
+    fifo_mq_t* mq = buffer->impl.mq;
+    fifo_mq_entry_t* entries;
+
+    //Claim every available item first; items already claimed by concurrent pulls are left for them
+    int claimed = atomic_exchange(&mq->available, 0);
+    int count = mqCollect(mq, &entries, claimed);
+
+    void** out = (void**) calloc(count + 1, sizeof(void*));
+    for (int i = 0; out != NULL && i < count; i++) out[i] = entries[i].data;
+    free(entries);
+
+    atomic_fetch_sub(&mq->reserved, count);
+    fifoCondBroadcast(&buffer->cond_nonfull);
+    return out;
+}
+
+int fifoMqSnapshot(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries) 
+{
+    fifo_mq_entry_t* all;
+    int count = mqCollect(buffer->impl.mq, &all, -1);
+    
+    int n = count < max_entries ? count : max_entries;
+    for (int i = 0; i < n; i++) 
+    {
+        entries[i].position = i;
+        entries[i].priority = all[i].priority;
+        entries[i].age_ns = 0;
+        entries[i].data = all[i].data;
+    }
+    free(all);
+    return n;
+}
+
+void fifoMqStats(fifo_buffer_t* buffer, fifo_stats_t* stats) 
+{
+    fifo_mq_t* mq = buffer->impl.mq;
+    memset(stats, 0, sizeof(*stats));
+    
+    for (int i = 0; i < mq->num_heaps; i++) 
+    {
+        fifo_mq_heap_t* heap = &mq->heaps[i];
+        fifoLockAcquire(&heap->lock);
+        stats->pushes += heap->pushes;
+        stats->pulls += heap->pulls;
+        fifoLockRelease(&heap->lock);
+    }
+    stats->occupancy = atomic_load(&mq->available);
+    stats->rank_error_sum = atomic_load(&mq->rank_error_sum);
+    stats->rank_error_samples = atomic_load(&mq->rank_error_samples);
+    stats->rank_error_max = atomic_load(&mq->rank_error_max);
+}
@@ -0,0 +1,327 @@
+/**
+ * Description: Key-partitioned FIFO. See fifo_partition.h
+ *  Every partition has an owner (a consumer id or -1) and a busy flag. A consumer claims the
+ *  busy flag before reading a partition, checks that it still owns it, and keeps the claim
+ *  while the item it pulled is in flight. The claim is what orders old and new owners across
+ *  a rebalance: a consumer scanning a stale assignment fails the owner check, and a new owner
+ *  cannot claim the partition before the old owner's item completes. Releasing a claim on a
+ *  partition owned by someone else notifies that owner, which may have skipped it as busy.
+ *
+ *  Rebalancing runs under the table lock. It stores the new owners, then publishes a fresh
+ *  assignment array to each consumer, retiring the old ones through epoch-based reclamation,
+ *  and finally notifies every consumer so each rescans with its new partitions.
+ **/
+#include "fifo_partition.h"
+#include "fifo.h"
+#include "fifo_epoch.h"
+#include "fifo_lock.h"
+#include <stdlib.h>
+
+typedef struct PartAssignment {
+    int count;
+    int partitions[];
+} fifo_part_assignment_t;
+
+typedef struct PartConsumer {
+    fifo_cond_t cond __attribute__((aligned(64)));      //notified on pushes to owned partitions
+    _Atomic(fifo_part_assignment_t*) assignment;        //NULL while not joined
+    atomic_bool active;
+    int in_flight;                                      //partition claimed for the last pulled item, or -1
+    int cursor;                                         //round-robin position in the assignment
+} fifo_part_consumer_t;
+
+typedef struct Partitioned {
+    int partitions;
+    int max_consumers;
+    fifo_buffer_t** buffers;
+    atomic_int* owner;                  //per partition: consumer id or -1
+    atomic_bool* busy;                  //per partition: claimed by a consumer
+    fifo_part_consumer_t* consumers;
+    fifo_lock_t table_lock;             //serializes joins, leaves and rebalancing
+} fifo_partitioned_t;
+
+static uint64_t partHash(uint64_t key) 
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    return key ^ (key >> 31);
+} //splitmix64 finalizer: sequential keys spread over all partitions
+
+static void partNotifyOwner(fifo_partitioned_t* part, int partition) 
+{
+    int owner = atomic_load(&part->owner[partition]);
+    if (owner >= 0) fifoCondNotify(&part->consumers[owner].cond);
+}
+
+//Releases consumer's claim on partition; wakes the owner if that is somebody else
+static void partRelease(fifo_partitioned_t* part, int consumer, int partition) 
+{
+    atomic_store(&part->busy[partition], false);
+    if (atomic_load(&part->owner[partition]) != consumer) partNotifyOwner(part, partition);
+}
+
+/**Pulls one item from the first readable partition of consumer's assignment, keeping the
+ * claim on that partition. Returns the partition or -1 if nothing could be read **/
+static int partScan(fifo_partitioned_t* part, int consumer, void** data_out) 
+{
+    fifo_part_consumer_t* c = &part->consumers[consumer];
+    int found = -1;
+
+    fifoEpochEnter();
+    fifo_part_assignment_t* assignment = atomic_load(&c->assignment);
+    for (int k = 0; assignment != NULL && k < assignment->count && found < 0; k++) 
+    {
+        int idx = (c->cursor + k) % assignment->count;
+        int p = assignment->partitions[idx];
+
+        bool expected = false;
+        if (!atomic_compare_exchange_strong(&part->busy[p], &expected, true)) continue; //item in flight at the previous owner
+        if (atomic_load(&part->owner[p]) != consumer) 
+        {
+            partRelease(part, consumer, p);
+            continue;
+        } //stale assignment: the partition moved
+
+        void* data = fifoPull(part->buffers[p], false);
+        if (data == NULL) 
+        {
+            partRelease(part, consumer, p); //p may have moved meanwhile; its new owner skipped it as busy
+            continue;
+        }
+        *data_out = data;
+        c->cursor = idx + 1;
+        found = p;
+    }
+    fifoEpochExit();
+    return found;
+}
+
+/**Assigns partitions to the active consumers, at most ceil(P/C) each, keeping a partition
+ * with its previous owner whenever that owner is still active and within its share. Caller
+ * holds the table lock **/
+static void partRebalanceLocked(fifo_partitioned_t* part) 
+{
+    int active = 0;
+    for (int i = 0; i < part->max_consumers; i++) if (atomic_load(&part->consumers[i].active)) active++;
+
+    int* owners = (int*) malloc((unsigned) part->partitions * sizeof(int));
+    int* counts = (int*) calloc((unsigned) part->max_consumers, sizeof(int));
+    if (owners == NULL || counts == NULL) 
+    {
+        free(owners);
+        free(counts);
+        return;
+    } //keep the current assignment; the next join or leave retries
+
+    int base = active > 0 ? part->partitions / active : 0;
+    int extra = active > 0 ? part->partitions % active : 0; //consumers that may hold base + 1
+    for (int p = 0; p < part->partitions; p++) 
+    {
+        int o = atomic_load(&part->owner[p]);
+        owners[p] = -1;
+        if (o < 0 || !atomic_load(&part->consumers[o].active)) continue;
+        if (counts[o] < base) owners[p] = o;
+        else if (counts[o] == base && extra > 0) 
+        {
+            owners[p] = o;
+            extra--;
+        }
+        if (owners[p] >= 0) counts[o]++;
+    } //sticky pass
+
+    int next = 0;
+    for (int p = 0; p < part->partitions && active > 0; p++) 
+    {
+        if (owners[p] >= 0) continue;
+        for (;; next = (next + 1) % part->max_consumers) 
+        {
+            if (!atomic_load(&part->consumers[next].active)) continue;
+            if (counts[next] < base) break;
+            if (counts[next] == base && extra > 0) 
+            {
+                extra--;
+                break;
+            }
+        }
+        owners[p] = next;
+        counts[next]++;
+    } //hand out the rest to consumers below their share
+
+    for (int p = 0; p < part->partitions; p++) atomic_store(&part->owner[p], owners[p]);
+
+    for (int i = 0; i < part->max_consumers; i++) 
+    {
+        fifo_part_consumer_t* c = &part->consumers[i];
+        fifo_part_assignment_t* assignment = NULL;
+        if (atomic_load(&c->active)) 
+        {
+            assignment = (fifo_part_assignment_t*) malloc(sizeof(fifo_part_assignment_t) + (size_t) counts[i] * sizeof(int));
+            if (assignment != NULL) 
+            {
+                assignment->count = 0;
+                for (int p = 0; p < part->partitions; p++) if (owners[p] == i) assignment->partitions[assignment->count++] = p;
+            } //on failure the consumer reads nothing until the next rebalance; its partitions wait
+        }
+        fifo_part_assignment_t* old = atomic_exchange(&c->assignment, assignment);
+        if (old != NULL) fifoEpochRetire(old, free); //a scan may still be walking it
+        fifoCondNotify(&c->cond);
+    } //owners are stored first, so a consumer reading its new assignment passes the owner check
+
+    free(owners);
+    free(counts);
+}
+
+fifo_partitioned_t* fifoPartitionedInit(int partitions, int partition_capacity, int max_consumers) 
+{
+    if (partitions <= 0 || max_consumers <= 0) return NULL;
+    fifo_partitioned_t* part = (fifo_partitioned_t*) calloc(1, sizeof(fifo_partitioned_t));
+    if (part == NULL) return NULL;
+    part->partitions = partitions;
+    part->max_consumers = max_consumers;
+    part->buffers = (fifo_buffer_t**) calloc(partitions, sizeof(fifo_buffer_t*));
+    part->owner = (atomic_int*) malloc(partitions * sizeof(atomic_int));
+    part->busy = (atomic_bool*) malloc(partitions * sizeof(atomic_bool));
+    if (posix_memalign((void**) &part->consumers, 64, max_consumers * sizeof(fifo_part_consumer_t)) != 0) part->consumers = NULL;
+    if (part->buffers == NULL || part->owner == NULL || part->busy == NULL || part->consumers == NULL || fifoLockInit(&part->table_lock, FIFO_LOCK_NORMAL) != 0) 
+    {
+        free(part->buffers);
+        free(part->owner);
+        free(part->busy);
+        free(part->consumers);
+        free(part);
+        return NULL;
+    }
+
+    for (int i = 0; i < max_consumers; i++) 
+    {
+        fifo_part_consumer_t* c = &part->consumers[i];
+        fifoCondInit(&c->cond);
+        atomic_init(&c->assignment, NULL);
+        atomic_init(&c->active, false);
+        c->in_flight = -1;
+        c->cursor = 0;
+    } //before any failure path below: fifoPartitionedClose reads the assignments
+
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    if (attr.lock_kind == FIFO_LOCK_NONE) attr.lock_kind = FIFO_LOCK_NORMAL; //partitions are shared by construction
+    for (int p = 0; p < partitions; p++) 
+    {
+        atomic_init(&part->owner[p], -1);
+        atomic_init(&part->busy[p], false);
+        part->buffers[p] = fifoBufferInitAttr(partition_capacity, NULL, &attr);
+        if (part->buffers[p] == NULL) 
+        {
+            free(fifoPartitionedClose(part));
+            return NULL;
+        }
+    }
+    return part;
+}
+
+void** fifoPartitionedClose(fifo_partitioned_t* part) 
+{
+    int total = 0;
+    void*** contents = (void***) calloc(part->partitions, sizeof(void**));
+    for (int p = 0; p < part->partitions && contents != NULL; p++) 
+    {
+        if (part->buffers[p] == NULL) continue;
+        contents[p] = fifoBufferClose(part->buffers[p]);
+        for (int i = 0; contents[p] != NULL && contents[p][i] != NULL; i++) total++;
+    }
+
+    void** out = (void**) malloc((total + 1) * sizeof(void*));
+    int n = 0;
+    for (int p = 0; p < part->partitions && contents != NULL; p++) 
+    {
+        for (int i = 0; out != NULL && contents[p] != NULL && contents[p][i] != NULL; i++) out[n++] = contents[p][i];
+        free(contents[p]);
+    }
+    if (out != NULL) out[n] = NULL;
+    free(contents);
+
+    for (int i = 0; i < part->max_consumers; i++) free(atomic_load(&part->consumers[i].assignment));
+    fifoLockDestroy(&part->table_lock);
+    free(part->buffers);
+    free(part->owner);
+    free(part->busy);
+    free(part->consumers);
+    free(part);
+    return out;
+}
+
+int fifoPartitionOf(const fifo_partitioned_t* part, uint64_t key) 
+{
+    return (int) (partHash(key) % (uint64_t) part->partitions);
+}
+
+int fifoPartitionedPush(fifo_partitioned_t* part, uint64_t key, void* data, bool blocking) 
+{
+    int p = fifoPartitionOf(part, key);
+    int status = fifoPush(part->buffers[p], data, 0, blocking);
+    if (status == 0) partNotifyOwner(part, p); //a stale owner is fine: the rebalance that moved p notified the new one
+    return status;
+}
+
+int fifoPartitionedJoin(fifo_partitioned_t* part) 
+{
+    fifoLockAcquire(&part->table_lock);
+    int id = -1;
+    for (int i = 0; i < part->max_consumers && id < 0; i++) 
+    {
+        if (!atomic_load(&part->consumers[i].active)) id = i;
+    }
+    if (id >= 0) 
+    {
+        part->consumers[id].in_flight = -1;
+        part->consumers[id].cursor = 0;
+        atomic_store(&part->consumers[id].active, true);
+        partRebalanceLocked(part);
+    }
+    fifoLockRelease(&part->table_lock);
+    return id;
+}
+
+void fifoPartitionedDone(fifo_partitioned_t* part, int consumer) 
+{
+    fifo_part_consumer_t* c = &part->consumers[consumer];
+    if (c->in_flight < 0) return;
+    int p = c->in_flight;
+    c->in_flight = -1;
+    partRelease(part, consumer, p);
+}
+
+void fifoPartitionedLeave(fifo_partitioned_t* part, int consumer) 
+{
+    fifo_part_consumer_t* c = &part->consumers[consumer];
+    fifoLockAcquire(&part->table_lock);
+    int in_flight = c->in_flight; //taken before the slot is freed: a join may reuse it at once
+    c->in_flight = -1;
+    atomic_store(&c->active, false);
+    partRebalanceLocked(part); //also wakes a pull blocked for this consumer
+    fifoLockRelease(&part->table_lock);
+    if (in_flight >= 0) partRelease(part, consumer, in_flight); //after the rebalance, so the new owner is the one notified
+}
+
+void* fifoPartitionedPull(fifo_partitioned_t* part, int consumer, bool blocking, int* partition_out) 
+{
+    fifo_part_consumer_t* c = &part->consumers[consumer];
+    fifoPartitionedDone(part, consumer);
+
+    void* data = NULL;
+    int p = partScan(part, consumer, &data);
+    while (p < 0 && blocking && atomic_load(&c->active)) 
+    {
+        unsigned seq = fifoCondEnterWait(&c->cond);
+        p = partScan(part, consumer, &data);
+        if (p < 0 && atomic_load(&c->active)) fifoFutexWait(&c->cond.seq, seq);
+        fifoCondLeaveWait(&c->cond);
+    } //rescan after announcing ourselves so a concurrent push or release cannot be missed
+    if (p < 0) return NULL;
+
+    c->in_flight = p;
+    if (partition_out != NULL) *partition_out = p;
+    return data;
+}
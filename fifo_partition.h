@@ -0,0 +1,59 @@
+/**
+ * Description: Key-partitioned FIFO. Pushes carry a 64-bit key (a customer, a session), keys
+ *  hash to a fixed set of partitions, each an ordinary first-in first-out fifo_buffer_t, and
+ *  every partition is owned by at most one consumer at a time. Items with equal keys are
+ *  therefore processed one after another in push order, while different partitions are
+ *  consumed in parallel, as with the partitions of a Kafka topic.
+ *
+ *  Consumers join and leave at any time. Each join or leave rebalances the partitions over
+ *  the current consumers, keeping as many partitions as possible with their previous owner.
+ *  An item stays "in flight" from the fifoPartitionedPull that returned it until the same
+ *  consumer calls fifoPartitionedPull again, fifoPartitionedDone or fifoPartitionedLeave, and
+ *  a partition that changed owner is not read by its new owner while an item from it is still
+ *  in flight at the old one, so rebalancing never breaks per-key order.
+ *
+ *  Pushes take only the lock of their partition. Consumers find their partitions through a
+ *  per-consumer assignment published by the rebalance and read under epoch protection, and
+ *  sleep on their own futex condition, so pulls never touch a shared lock either.
+ **/
+
+#ifndef _FIFO_PARTITION_H_
+#define _FIFO_PARTITION_H_
+
+    #include <stdbool.h>
+    #include <stdint.h>
+
+    typedef struct Partitioned fifo_partitioned_t; //defined in fifo_partition.c
+
+    //Creates partitions partitions of partition_capacity items each, for up to max_consumers
+    //consumers joined at once. Returns NULL on failure
+    fifo_partitioned_t* fifoPartitionedInit(int partitions, int partition_capacity, int max_consumers);
+
+    //Frees the structure. No consumer may be inside a call. Returns the remaining items in a
+    //NULL-terminated array, partition by partition, each partition in first-out order
+    void** fifoPartitionedClose(fifo_partitioned_t* part);
+
+    //Partition that key maps to
+    int fifoPartitionOf(const fifo_partitioned_t* part, uint64_t key);
+
+    //Appends data to the partition of key. Returns as fifoPush: 0, -1 if the partition is full
+    //and blocking is not set, or an error code
+    int fifoPartitionedPush(fifo_partitioned_t* part, uint64_t key, void* data, bool blocking);
+
+    //Registers a consumer and rebalances. Returns its id, or -1 if max_consumers are joined
+    int fifoPartitionedJoin(fifo_partitioned_t* part);
+
+    //Deregisters consumer, completing its in-flight item, and rebalances its partitions onto the
+    //others. Call from the consumer's thread, or from another one while the consumer is blocked
+    //in fifoPartitionedPull, which then returns NULL
+    void fifoPartitionedLeave(fifo_partitioned_t* part, int consumer);
+
+    //Completes consumer's in-flight item, if any, then returns the next item from one of its
+    //partitions, or NULL if there is none and blocking is not set. Partitions are served round
+    //robin. If partition_out is non-NULL it receives the item's partition
+    void* fifoPartitionedPull(fifo_partitioned_t* part, int consumer, bool blocking, int* partition_out);
+
+    //Completes consumer's in-flight item without pulling another one, so its partition may be
+    //handed to a new owner straight away
+    void fifoPartitionedDone(fifo_partitioned_t* part, int consumer);
+#endif
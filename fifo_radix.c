@@ -0,0 +1,293 @@
+/**
+ * Description: Radix heap backend (FIFO_BACKEND_RADIX) for monotone 64-bit keys such as
+ *  enqueue timestamps or sequence numbers. Keys are served smallest first and must never be
+ *  below the last key pulled. A node with key k lives in bucket 0 if k equals that last key,
+ *  otherwise in bucket 1 + (index of the highest bit in which k and the last key differ).
+ *  Every key in bucket i is smaller than every key in bucket i+1, so a pull takes the head of
+ *  bucket 0, or first redistributes the lowest non-empty bucket around its minimum. Each node
+ *  moves to a lower bucket at most 64 times, giving O(1) push and O(log C) amortized pull,
+ *  where C is the spread of the queued keys.
+ *
+ *  Buckets are first-in first-out lists and redistribution keeps their order, so equal keys
+ *  are pulled in push order. The backend is protected by the buffer lock and waits on the
+ *  buffer conditions, exactly as the list backend does; direct hand-off is not used.
+ **/
+#include "fifo_internal.h"
+#include <limits.h>
+
+#define RADIX_BUCKETS 65
+
+typedef struct RadixNode {
+    struct RadixNode* next;
+    void* data;
+    uint64_t key;
+    uint64_t enqueue_ns;
+} fifo_radix_node_t;
+
+typedef struct RadixHeap {
+    uint64_t last;                          //smallest key that may still be pushed
+    fifo_radix_node_t* head[RADIX_BUCKETS];
+    fifo_radix_node_t* tail[RADIX_BUCKETS];
+} fifo_radix_t;
+
+static int radixBucket(uint64_t last, uint64_t key) 
+{
+    return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+}
+
+static void radixAppend(fifo_radix_t* heap, int bucket, fifo_radix_node_t* node) 
+{
+    node->next = NULL;
+    if (heap->tail[bucket] != NULL) heap->tail[bucket]->next = node;
+    else heap->head[bucket] = node;
+    heap->tail[bucket] = node;
+}
+
+/**Makes bucket 0 non-empty if any bucket is: advances last to the minimum of the lowest
+ * non-empty bucket and redistributes that bucket, in order. Returns false if the heap is empty **/
+static bool radixRefill(fifo_radix_t* heap) 
+{
+    if (heap->head[0] != NULL) return true;
+
+    int i = 1;
+    while (i < RADIX_BUCKETS && heap->head[i] == NULL) i++;
+    if (i == RADIX_BUCKETS) return false;
+
+    fifo_radix_node_t* p = heap->head[i];
+    uint64_t min = p->key;
+    for (p = p->next; p != NULL; p = p->next) if (p->key < min) min = p->key;
+
+    p = heap->head[i];
+    heap->head[i] = heap->tail[i] = NULL;
+    heap->last = min;
+    while (p != NULL) 
+    {
+        fifo_radix_node_t* next = p->next;
+        radixAppend(heap, radixBucket(min, p->key), p); //always lands below i
+        p = next;
+    }
+    return true;
+}
+
+//Snapshot order of two entries whose data holds the node: by key, then by list position
+static bool radixEntryBefore(const fifo_snapshot_entry_t* a, const fifo_snapshot_entry_t* b) 
+{
+    uint64_t ka = ((fifo_radix_node_t*) a->data)->key;
+    uint64_t kb = ((fifo_radix_node_t*) b->data)->key;
+    return ka != kb ? ka < kb : a->position < b->position;
+}
+
+//Restores the max-heap (last in snapshot order on top) below index i of heap[0..n)
+static void radixEntrySiftDown(fifo_snapshot_entry_t* heap, int i, int n) 
+{
+    for (;;) 
+    {
+        int top = i, l = 2 * i + 1, r = l + 1;
+        if (l < n && radixEntryBefore(&heap[top], &heap[l])) top = l;
+        if (r < n && radixEntryBefore(&heap[top], &heap[r])) top = r;
+        if (top == i) return;
+        fifo_snapshot_entry_t t = heap[i];
+        heap[i] = heap[top];
+        heap[top] = t;
+        i = top;
+    }
+}
+
+struct RadixHeap* fifoRadixCreate(void) 
+{
+    fifo_radix_t* heap = (fifo_radix_t*) calloc(1, sizeof(fifo_radix_t));
+    return heap;
+}
+
+void fifoRadixDestroy(struct RadixHeap* heap) 
+{
+    for (int i = 0; i < RADIX_BUCKETS; i++) 
+    {
+        fifo_radix_node_t* p = heap->head[i];
+        while (p != NULL) 
+        {
+            fifo_radix_node_t* next = p->next;
+            free(p);
+            p = next;
+        }
+    }
+    free(heap);
+}
+
+/**Pushes data with the given key, or with the current last key if at_last is set (the
+ * earliest slot that is still open). Returns EINVAL if key is below the last pulled key **/
+int fifoRadixPush(fifo_buffer_t* buffer, void* data, uint64_t key, bool at_last, bool blocking) 
+{
+    fifo_radix_t* heap = buffer->impl.radix;
+    fifo_radix_node_t* node = (fifo_radix_node_t*) malloc(sizeof(fifo_radix_node_t));
+    if (node == NULL) return ENOMEM;
+    node->data = data;
+    node->enqueue_ns = fifoNowNs();
+
+    int lock_status = fifoLockBuffer(buffer,blocking);
+    if (lock_status != 0) 
+    {
+        free(node);
+        return lock_status;
+    }
+
+    while (buffer->buffer_occupancy >= buffer->max_buffer_size) 
+    {
+        if (blocking) 
+        {
+            unsigned seq = fifoCondPrepare(&buffer->cond_nonfull);
+            int cond_status = fifoCondWait(&buffer->cond_nonfull, &buffer->lock, seq);
+            if (cond_status != 0) 
+            {
+                free(node);
+                return cond_status;
+            }
+        } //loop guards against spurious wake-ups
+        else 
+        {
+#if FIFO_ENABLE_STATS
+            buffer->stats.push_rejects++;
+#endif
+            fifoLockRelease(&buffer->lock);
+            free(node);
+            return -1;
+        }
+    }
+
+    if (at_last) key = heap->last;
+    else if (key < heap->last) 
+    {
+        fifoLockRelease(&buffer->lock);
+        free(node);
+        return EINVAL;
+    } //checked after the wait: last may have advanced meanwhile
+
+    node->key = key;
+    radixAppend(heap, radixBucket(heap->last, key), node);
+    buffer->buffer_occupancy++;
+#if FIFO_ENABLE_STATS
+    buffer->stats.pushes++;
+    if (buffer->buffer_occupancy > buffer->stats.peak_occupancy) buffer->stats.peak_occupancy = buffer->buffer_occupancy;
+#endif
+
+    fifoCondSignal(&buffer->cond_nonempty);
+    fifoLockRelease(&buffer->lock);
+    return 0;
+}
+
+//Removes the smallest-key node. Caller holds the lock and has verified the heap is non-empty
+static fifo_radix_node_t* radixPopLocked(fifo_buffer_t* buffer) 
+{
+    fifo_radix_t* heap = buffer->impl.radix;
+    radixRefill(heap);
+    fifo_radix_node_t* node = heap->head[0];
+    heap->head[0] = node->next;
+    if (heap->head[0] == NULL) heap->tail[0] = NULL;
+
+    buffer->buffer_occupancy--;
+#if FIFO_ENABLE_STATS
+    buffer->stats.pulls++;
+#endif
+    return node;
+}
+
+void* fifoRadixPull(fifo_buffer_t* buffer, bool blocking) 
+{
+    int lock_status = fifoLockBuffer(buffer,blocking);
+    if (lock_status != 0) return NULL;
+
+    while (buffer->buffer_occupancy <= 0) 
+    {
+        if (blocking) 
+        {
+            unsigned seq = fifoCondPrepare(&buffer->cond_nonempty);
+            if (fifoCondWait(&buffer->cond_nonempty, &buffer->lock, seq) != 0) return NULL;
+        } //loop guards against spurious wake-ups
+        else 
+        {
+            fifoLockRelease(&buffer->lock);
+            return NULL;
+        }
+    }
+
+    fifo_radix_node_t* node = radixPopLocked(buffer);
+    fifoCondSignal(&buffer->cond_nonfull);
+    fifoLockRelease(&buffer->lock);
+
+    void* data = node->data;
+    free(node);
+    return data;
+}
+
+void** fifoRadixFlush(fifo_buffer_t* buffer, bool blocking) 
+{
+    int lock_status = fifoLockBuffer(buffer,blocking);
+    if (lock_status != 0) return NULL;
+
+    void** out = (void**) calloc(buffer->buffer_occupancy + 1, sizeof(void*));
+    int i = 0;
+    while (buffer->buffer_occupancy > 0) 
+    {
+        fifo_radix_node_t* node = radixPopLocked(buffer);
+        out[i++] = node->data;
+        free(node);
+    } //pull order, so the array is first-out first as for the other backends
+    out[i] = NULL;
+
+    fifoCondBroadcast(&buffer->cond_nonfull);
+    fifoLockRelease(&buffer->lock);
+    return out;
+}
+
+int fifoRadixSnapshotLocked(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries, uint64_t now) 
+{
+    fifo_radix_t* heap = buffer->impl.radix;
+    int count = 0;
+    for (int b = 0; b < RADIX_BUCKETS && count < max_entries; b++) 
+    {
+        //Buckets are ordered by key but unsorted inside. Keep the smallest room nodes of this
+        //one in a max-heap built in the caller's entries, then heap-sort them; the bucket itself
+        //is left untouched
+        fifo_snapshot_entry_t* out = entries + count;
+        int room = max_entries - count;
+        int n = 0, seq = 0;
+        for (fifo_radix_node_t* p = heap->head[b]; p != NULL; p = p->next, seq++) 
+        {
+            fifo_snapshot_entry_t e = { .position = seq, .data = p }; //node and list position until sorted
+            if (n < room) 
+            {
+                int i = n++;
+                out[i] = e;
+                while (i > 0 && radixEntryBefore(&out[(i - 1) / 2], &out[i])) 
+                {
+                    fifo_snapshot_entry_t t = out[i];
+                    out[i] = out[(i - 1) / 2];
+                    out[(i - 1) / 2] = t;
+                    i = (i - 1) / 2;
+                }
+            }
+            else if (radixEntryBefore(&e, &out[0])) 
+            {
+                out[0] = e;
+                radixEntrySiftDown(out, 0, n);
+            }
+        }
+        for (int end = n - 1; end > 0; end--) 
+        {
+            fifo_snapshot_entry_t t = out[0];
+            out[0] = out[end];
+            out[end] = t;
+            radixEntrySiftDown(out, 0, end);
+        }
+
+        for (int i = 0; i < n; i++, count++) 
+        {
+            fifo_radix_node_t* p = (fifo_radix_node_t*) out[i].data;
+            entries[count].position = count;
+            entries[count].priority = p->key > INT_MAX ? INT_MAX : (int) p->key; //saturates; see fifo_snapshot_entry_t
+            entries[count].age_ns = now - p->enqueue_ns;
+            entries[count].data = p->data;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,80 @@
+/**
+ * Description: Lock-free registry of live, named FIFO buffers.
+ *  The registry is a fixed array of slots. A buffer claims a slot with a single CAS
+ *  and releases it with a single store, so creating and destroying buffers never
+ *  serializes on a registry lock. Dumps pin a slot with a reader count; removal
+ *  clears the slot and then waits for the pin count to drain before the buffer
+ *  can be freed.
+ **/
+#include "fifo_internal.h"
+#include <stdatomic.h>
+#include <sched.h>
+
+typedef struct RegistrySlot {
+    _Atomic(fifo_buffer_t*) buffer;
+    atomic_int readers;
+} fifo_registry_slot_t;
+
+static fifo_registry_slot_t registry[FIFO_REGISTRY_SIZE];
+#if FIFO_ENABLE_REGISTRY
+static atomic_uint registry_hint; //rotating start index so concurrent registrations rarely collide
+#endif
+
+int fifoRegistryAdd(fifo_buffer_t* buffer) 
+{
+#if !FIFO_ENABLE_REGISTRY
+    (void) buffer;
+    return -1;
+#else
+    unsigned start = atomic_fetch_add_explicit(&registry_hint, 1, memory_order_relaxed);
+
+    for (int i = 0; i < FIFO_REGISTRY_SIZE; i++) 
+    {
+        int slot = (start + i) % FIFO_REGISTRY_SIZE;
+        fifo_buffer_t* expected = NULL;
+        if (atomic_compare_exchange_strong(&registry[slot].buffer, &expected, buffer)) return slot;
+    }
+
+    return -1; //registry full; buffer remains usable but unlisted
+#endif
+}
+
+void fifoRegistryRemove(fifo_buffer_t* buffer) 
+{
+    if (buffer->registry_slot < 0) return;
+
+    fifo_registry_slot_t* slot = &registry[buffer->registry_slot];
+    atomic_store(&slot->buffer, NULL);
+    
+    //A dump that pinned the slot before the store may still be reading the buffer
+    while (atomic_load(&slot->readers) != 0) sched_yield();
+
+    buffer->registry_slot = -1;
+}
+
+void fifoRegistryDump(FILE* stream) 
+{
+    fprintf(stream, "%-*s %10s %10s %12s %12s %12s %10s  %s\n", FIFO_NAME_MAX - 1,
+            "name", "capacity", "occupancy", "pushes", "pulls", "rejects", "peak", "backend");
+
+#if FIFO_ENABLE_REGISTRY
+    for (int i = 0; i < FIFO_REGISTRY_SIZE; i++) 
+    {
+        fifo_registry_slot_t* slot = &registry[i];
+        if (atomic_load_explicit(&slot->buffer, memory_order_relaxed) == NULL) continue;
+
+        atomic_fetch_add(&slot->readers, 1);
+        fifo_buffer_t* buffer = atomic_load(&slot->buffer); //re-read now that the slot is pinned
+        if (buffer != NULL) 
+        {
+            fifo_stats_t stats = {0};
+            if (fifoGetStats(buffer, &stats) != 0) stats.occupancy = -1;
+
+            fprintf(stream, "%-*s %10d %10d %12lu %12lu %12lu %10d  %s\n", FIFO_NAME_MAX - 1,
+                    buffer->name, buffer->max_buffer_size, stats.occupancy, stats.pushes, stats.pulls,
+                    stats.push_rejects, stats.peak_occupancy, fifoBackendName(buffer->backend));
+        }
+        atomic_fetch_sub(&slot->readers, 1);
+    }
+#endif
+}
@@ -0,0 +1,108 @@
+/**
+ * Description: Reorder ring. See fifo_sequencer.h
+ *  Ticket t lives in slot t % window. A slot is ready for ticket t when its ready word holds
+ *  t + 1, so stale values from earlier laps never match and slots need no reset. Tickets are
+ *  issued under a pull lock that also covers the source pull, which is what makes ticket
+ *  order equal pull order.
+ **/
+#include "fifo_sequencer.h"
+
+typedef struct SequencerSlot {
+    atomic_uint_fast64_t ready;         //ticket + 1 once the result for ticket is stored
+    void* result;
+} fifo_sequencer_slot_t;
+
+typedef struct Sequencer {
+    fifo_buffer_t* source;
+    uint64_t window;
+    fifo_lock_t pull_lock;                              //orders source pulls with ticket issue
+    uint64_t next_ticket;                               //under pull_lock
+    atomic_uint_fast64_t released __attribute__((aligned(64)));    //tickets handed to the consumer
+    fifo_cond_t cond_space;                             //workers waiting for the window to open
+    fifo_cond_t cond_ready __attribute__((aligned(64)));           //consumer waiting for the next result
+    fifo_sequencer_slot_t* slots;
+} fifo_sequencer_t;
+
+fifo_sequencer_t* fifoSequencerCreate(fifo_buffer_t* source, int window) 
+{
+    if (window <= 0) return NULL;
+    fifo_sequencer_t* sequencer;
+    if (posix_memalign((void**) &sequencer, 64, sizeof(fifo_sequencer_t)) != 0) return NULL;
+    sequencer->slots = (fifo_sequencer_slot_t*) malloc((unsigned) window * sizeof(fifo_sequencer_slot_t));
+    if (sequencer->slots == NULL || fifoLockInit(&sequencer->pull_lock, FIFO_LOCK_NORMAL) != 0) 
+    {
+        free(sequencer->slots);
+        free(sequencer);
+        return NULL;
+    }
+
+    sequencer->source = source;
+    sequencer->window = (uint64_t) window;
+    sequencer->next_ticket = 0;
+    atomic_init(&sequencer->released, 0);
+    fifoCondInit(&sequencer->cond_space);
+    fifoCondInit(&sequencer->cond_ready);
+    for (int i = 0; i < window; i++) 
+    {
+        atomic_init(&sequencer->slots[i].ready, 0);
+        sequencer->slots[i].result = NULL;
+    }
+    return sequencer;
+}
+
+void fifoSequencerDestroy(fifo_sequencer_t* sequencer) 
+{
+    fifoLockDestroy(&sequencer->pull_lock);
+    free(sequencer->slots);
+    free(sequencer);
+}
+
+void* fifoSequencerPull(fifo_sequencer_t* sequencer, uint64_t* ticket, bool blocking) 
+{
+    int lock_status = blocking ? fifoLockAcquire(&sequencer->pull_lock) : fifoLockTryAcquire(&sequencer->pull_lock);
+    if (lock_status != 0) return NULL;
+
+    while (sequencer->next_ticket - atomic_load(&sequencer->released) >= sequencer->window) 
+    {
+        if (!blocking) 
+        {
+            fifoLockRelease(&sequencer->pull_lock);
+            return NULL;
+        }
+        unsigned seq = fifoCondEnterWait(&sequencer->cond_space);
+        if (sequencer->next_ticket - atomic_load(&sequencer->released) >= sequencer->window) fifoFutexWait(&sequencer->cond_space.seq, seq);
+        fifoCondLeaveWait(&sequencer->cond_space);
+    } //back-pressure: the slot for next_ticket still holds an unreleased result
+
+    void* data = fifoPull(sequencer->source, blocking);
+    if (data != NULL) *ticket = sequencer->next_ticket++;
+    fifoLockRelease(&sequencer->pull_lock);
+    return data;
+}
+
+void fifoSequencerComplete(fifo_sequencer_t* sequencer, uint64_t ticket, void* result) 
+{
+    fifo_sequencer_slot_t* slot = &sequencer->slots[ticket % sequencer->window];
+    slot->result = result;
+    atomic_store_explicit(&slot->ready, ticket + 1, memory_order_release);
+    fifoCondNotify(&sequencer->cond_ready);
+}
+
+bool fifoSequencerNext(fifo_sequencer_t* sequencer, void** result, bool blocking) 
+{
+    uint64_t ticket = atomic_load_explicit(&sequencer->released, memory_order_relaxed); //only the consumer writes it
+    fifo_sequencer_slot_t* slot = &sequencer->slots[ticket % sequencer->window];
+
+    while (atomic_load_explicit(&slot->ready, memory_order_acquire) != ticket + 1) 
+    {
+        if (!blocking) return false;
+        unsigned seq = fifoCondEnterWait(&sequencer->cond_ready);
+        if (atomic_load(&slot->ready) != ticket + 1) fifoFutexWait(&sequencer->cond_ready.seq, seq);
+        fifoCondLeaveWait(&sequencer->cond_ready);
+    } //recheck after announcing ourselves so a concurrent completion cannot be missed
+
+    *result = slot->result;
+    atomic_store(&sequencer->released, ticket + 1);
+    fifoCondNotify(&sequencer->cond_space);
+    return true;
+}
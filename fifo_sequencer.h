@@ -0,0 +1,45 @@
+/**
+ * Description: Sequencer for ordered parallel processing. Worker threads pull items from a
+ *  source fifo_buffer_t through the sequencer, which stamps each item with a ticket, its
+ *  position in pull order. Workers process items concurrently and hand each result back
+ *  with its ticket, in any order. A single consumer then receives the results strictly in
+ *  ticket order through a bounded reorder ring.
+ *
+ *  The ring holds window results. A worker may pull ticket t only once ticket t - window has
+ *  been released to the consumer, so a slow item holds back at most window items: workers
+ *  block in fifoSequencerPull until the consumer catches up (back-pressure) and memory stays
+ *  bounded however far ahead the other workers are.
+ *
+ *  Completion is a store and a fence; the consumer and blocked workers sleep on futex
+ *  conditions and are woken only when they are actually waiting.
+ **/
+
+#ifndef _FIFO_SEQUENCER_H_
+#define _FIFO_SEQUENCER_H_
+
+    #include <stdbool.h>
+    #include <stdint.h>
+    #include "fifo.h"
+
+    typedef struct Sequencer fifo_sequencer_t; //defined in fifo_sequencer.c
+
+    //Creates a sequencer over source with a reorder window of window results. The source is
+    //not owned and must outlive the sequencer. Returns NULL on failure
+    fifo_sequencer_t* fifoSequencerCreate(fifo_buffer_t* source, int window);
+
+    //Frees the sequencer. Results not yet received are dropped
+    void fifoSequencerDestroy(fifo_sequencer_t* sequencer);
+
+    //Worker: pulls the next item from the source and stores its ticket in *ticket. Every ticket
+    //handed out must be completed. Blocks while the window is full and, as fifoPull, while the
+    //source is empty. Returns NULL if nothing was pulled (non-blocking, or fifoPull failed)
+    void* fifoSequencerPull(fifo_sequencer_t* sequencer, uint64_t* ticket, bool blocking);
+
+    //Worker: publishes the result for ticket. result may be NULL
+    void fifoSequencerComplete(fifo_sequencer_t* sequencer, uint64_t ticket, void* result);
+
+    //Consumer: stores the result of the oldest unreleased ticket in *result and releases it,
+    //waiting for its completion if blocking. Returns false if it was not completed yet. One
+    //consumer thread at a time
+    bool fifoSequencerNext(fifo_sequencer_t* sequencer, void** result, bool blocking);
+#endif
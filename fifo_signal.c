@@ -0,0 +1,125 @@
+/**
+ * Description: Async-signal-safe push path. fifoPushSignalSafe stores data into a ring
+ *  preallocated at buffer init (fifo_attr_t.signal_ring), using only atomic operations, and
+ *  then wakes consumers with a futex signal on cond_nonempty and, optionally, a write to an
+ *  eventfd. It takes no lock and never allocates, so it may be called from a signal handler,
+ *  including one that interrupted a thread inside another fifo call on the same buffer.
+ *
+ *  The ring is the bounded MPMC queue of D. Vyukov: every cell carries a sequence number
+ *  that tells producers and the consumer whose turn the cell is. Consumers move ring items
+ *  into the buffer under the buffer lock (fifoSignalDrainLocked in fifo.c), where they are
+ *  ordered by priority like any other push. A producer interrupted between claiming and
+ *  filling a cell only delays items behind it; it never blocks another producer.
+ **/
+#include "fifo_internal.h"
+#include <limits.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+typedef struct SignalCell {
+    atomic_size_t seq;
+    void* data;
+    int priority;
+} fifo_signal_cell_t;
+
+typedef struct SignalRing {
+    atomic_size_t enqueue_pos __attribute__((aligned(64)));
+    atomic_size_t dequeue_pos __attribute__((aligned(64)));
+    size_t mask;
+    int event_fd;                   //-1 if not requested
+    fifo_signal_cell_t cells[];
+} fifo_signal_ring_t;
+
+struct SignalRing* fifoSignalRingCreate(int capacity, bool use_eventfd) 
+{
+    size_t size = 2;
+    while (size < (size_t) capacity) size <<= 1;
+
+    fifo_signal_ring_t* ring;
+    if (posix_memalign((void**) &ring, 64, sizeof(fifo_signal_ring_t) + size * sizeof(fifo_signal_cell_t)) != 0) return NULL;
+    for (size_t i = 0; i < size; i++) atomic_init(&ring->cells[i].seq, i);
+    atomic_init(&ring->enqueue_pos, 0);
+    atomic_init(&ring->dequeue_pos, 0);
+    ring->mask = size - 1;
+
+    ring->event_fd = -1;
+    if (use_eventfd) 
+    {
+        ring->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (ring->event_fd < 0) 
+        {
+            free(ring);
+            return NULL;
+        }
+    }
+    return ring;
+}
+
+void fifoSignalRingDestroy(struct SignalRing* ring) 
+{
+    if (ring->event_fd >= 0) close(ring->event_fd);
+    free(ring);
+}
+
+//Consumer side. Caller holds the buffer lock, which makes it the only consumer
+bool fifoSignalRingPop(struct SignalRing* ring, void** data, int* priority) 
+{
+    size_t pos = atomic_load_explicit(&ring->dequeue_pos, memory_order_relaxed);
+    fifo_signal_cell_t* cell = &ring->cells[pos & ring->mask];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1) return false; //empty, or next cell not filled yet
+
+    *data = cell->data;
+    *priority = cell->priority;
+    atomic_store_explicit(&ring->dequeue_pos, pos + 1, memory_order_relaxed);
+    atomic_store_explicit(&cell->seq, pos + ring->mask + 1, memory_order_release); //hand the cell back to producers
+    return true;
+}
+
+//Items claimed by producers and not yet popped, including cells still being filled
+int fifoSignalRingCount(struct SignalRing* ring) 
+{
+    size_t count = atomic_load(&ring->enqueue_pos) - atomic_load(&ring->dequeue_pos);
+    return count > INT_MAX ? INT_MAX : (int) count;
+}
+
+int fifoPushSignalSafe(fifo_buffer_t* buffer, void* data, int priority) 
+{
+    fifo_signal_ring_t* ring = buffer->signal_ring;
+    if (ring == NULL) return ENOTSUP;
+
+    size_t pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    fifo_signal_cell_t* cell;
+    for (;;) 
+    {
+        cell = &ring->cells[pos & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t) seq - (intptr_t) pos;
+        if (dif == 0) 
+        {
+            if (atomic_compare_exchange_weak_explicit(&ring->enqueue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        } //cell free for this position: claim it
+        else if (dif < 0) return -1; //full
+        else pos = atomic_load_explicit(&ring->enqueue_pos, memory_order_relaxed);
+    }
+    cell->data = data;
+    cell->priority = priority;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+    //Wake-ups use only atomics, the futex syscall and write(2), all async-signal-safe. Both
+    //syscalls may set errno, which the interrupted code must not see change
+    int saved_errno = errno;
+    fifoCondSignal(&buffer->cond_nonempty);
+    if (ring->event_fd >= 0) 
+    {
+        uint64_t one = 1;
+        ssize_t written = write(ring->event_fd, &one, sizeof(one));
+        (void) written; //EAGAIN only if the counter would overflow; readers are awake then anyway
+    }
+    errno = saved_errno;
+    return 0;
+}
+
+int fifoSignalFd(fifo_buffer_t* buffer) 
+{
+    return buffer->signal_ring != NULL ? buffer->signal_ring->event_fd : -1;
+}
@@ -0,0 +1,332 @@
+/**
+ * Description: Lock-free skip-list priority backend (FIFO_BACKEND_SKIPLIST), after
+ *  Linden & Jonsson, "A Skiplist-Based Concurrent Priority Queue with Minimal Memory Contention".
+ *  Inserts at different priorities touch different parts of the list and proceed in parallel.
+ *  A pull logically deletes the first live node by setting the mark bit in its predecessor's
+ *  level-0 pointer with one fetch-and-or, so deleted nodes always form a prefix of the list.
+ *  The prefix is only unlinked in a batch, once it is longer than FIFO_SKIPLIST_BOUND, by one
+ *  CAS on the head; unlinked nodes are released through epoch-based reclamation.
+ *  Pulls are linearizable and return elements in exactly the list backend's order:
+ *  negative priorities first (latest first), then higher priorities, ties first-in first-out.
+ **/
+#include "fifo_internal.h"
+#include "fifo_epoch.h"
+#include <limits.h>
+#include <string.h>
+
+#define SKIP_LEVELS 32
+
+//Level-0 pointers carry the deletion mark of the node they point to in their low bit
+#define MARKED(p)   ((uintptr_t) (p) & 1)
+#define UNMARK(p)   ((fifo_skip_node_t*) ((uintptr_t) (p) & ~(uintptr_t) 1))
+#define MARK(p)     ((uintptr_t) (p) | 1)
+
+typedef struct SkipNode {
+    uint64_t rank;          //primary sort key, ascending; derived from the priority
+    uint64_t seq;           //secondary key, makes every key unique and orders ties
+    void* data;
+    int priority;
+    int level;
+    atomic_bool inserting;  //upper levels still being linked; must not become the new head
+    _Atomic(uintptr_t) next[];
+} fifo_skip_node_t;
+
+typedef struct SkipList {
+    fifo_skip_node_t* head;
+    fifo_skip_node_t* tail;
+    atomic_ulong seq __attribute__((aligned(64)));
+    atomic_int reserved __attribute__((aligned(64)));   //elements in the list, for capacity
+} fifo_skiplist_t;
+
+static __thread uint64_t skip_rng;
+
+static int skipRandomLevel(void) 
+{
+    if (skip_rng == 0) skip_rng = ((uintptr_t) &skip_rng * 0x9E3779B97F4A7C15ull) | 1;
+    skip_rng ^= skip_rng << 13;
+    skip_rng ^= skip_rng >> 7;
+    skip_rng ^= skip_rng << 17;
+    int level = __builtin_ctzll(skip_rng | (1ull << (SKIP_LEVELS - 1))) + 1; //P(level > l) = 2^-l
+    return level < SKIP_LEVELS ? level : SKIP_LEVELS;
+}
+
+static bool skipLess(const fifo_skip_node_t* node, uint64_t rank, uint64_t seq) 
+{
+    return node->rank < rank || (node->rank == rank && node->seq < seq);
+}
+
+static fifo_skip_node_t* skipNodeCreate(int level, uint64_t rank, uint64_t seq) 
+{
+    fifo_skip_node_t* node = (fifo_skip_node_t*) malloc(sizeof(fifo_skip_node_t) + level * sizeof(_Atomic(uintptr_t)));
+    if (node == NULL) return NULL;
+    node->rank = rank;
+    node->seq = seq;
+    node->data = NULL;
+    node->priority = 0;
+    node->level = level;
+    atomic_init(&node->inserting, false);
+    for (int i = 0; i < level; i++) atomic_init(&node->next[i], 0);
+    return node;
+}
+
+struct SkipList* fifoSkipCreate(void) 
+{
+    fifo_skiplist_t* list = NULL;
+    if (posix_memalign((void**) &list, 64, sizeof(fifo_skiplist_t)) != 0) return NULL;
+    
+    list->head = skipNodeCreate(SKIP_LEVELS, 0, 0);
+    list->tail = skipNodeCreate(SKIP_LEVELS, UINT64_MAX, UINT64_MAX);
+    if (list->head == NULL || list->tail == NULL) 
+    {
+        free(list->head);
+        free(list->tail);
+        free(list);
+        return NULL;
+    }
+    for (int i = 0; i < SKIP_LEVELS; i++) atomic_init(&list->head->next[i], (uintptr_t) list->tail);
+    atomic_init(&list->seq, 1);
+    atomic_init(&list->reserved, 0);
+    return list;
+}
+
+void fifoSkipDestroy(struct SkipList* list) 
+{
+    fifo_skip_node_t* node = list->head;
+    while (node != NULL) 
+    {
+        fifo_skip_node_t* next = UNMARK(atomic_load(&node->next[0]));
+        free(node);
+        node = next;
+    } //head, any unreclaimed deleted prefix, live nodes and tail
+    free(list);
+}
+
+//Fills preds/succs for key (rank, seq) on every level, skipping deleted nodes.
+//Returns the last deleted node passed on level 0, or NULL
+static fifo_skip_node_t* skipLocatePreds(fifo_skiplist_t* list, uint64_t rank, uint64_t seq,
+                                         fifo_skip_node_t** preds, fifo_skip_node_t** succs) 
+{
+    fifo_skip_node_t* x = list->head;
+    fifo_skip_node_t* del = NULL;
+
+    for (int i = SKIP_LEVELS - 1; i >= 0; i--) 
+    {
+        fifo_skip_node_t* cur = UNMARK(atomic_load(&x->next[i]));
+        bool d = MARKED(atomic_load(&x->next[0]));
+        while (skipLess(cur, rank, seq) || MARKED(atomic_load(&cur->next[0])) || (i == 0 && d)) 
+        {
+            if (d && i == 0) del = cur;
+            x = cur;
+            cur = UNMARK(atomic_load(&x->next[i]));
+            d = MARKED(atomic_load(&x->next[0]));
+        }
+        preds[i] = x;
+        succs[i] = cur;
+    }
+    return del;
+}
+
+static int skipInsert(fifo_skiplist_t* list, void* data, int priority) 
+{
+    //Served first = smallest key. Negative priorities sort before all others, latest first;
+    //non-negative ones by descending priority, earliest first
+    uint64_t counter = atomic_fetch_add_explicit(&list->seq, 1, memory_order_relaxed);
+    uint64_t rank = priority < 0 ? 1 : 2 + (uint64_t) (INT_MAX - priority);
+    uint64_t seq = priority < 0 ? UINT64_MAX - 1 - counter : counter;
+
+    int level = skipRandomLevel();
+    fifo_skip_node_t* node = skipNodeCreate(level, rank, seq);
+    if (node == NULL) return ENOMEM;
+    node->data = data;
+    node->priority = priority;
+    atomic_store(&node->inserting, true);
+
+    fifo_skip_node_t* preds[SKIP_LEVELS];
+    fifo_skip_node_t* succs[SKIP_LEVELS];
+    fifo_skip_node_t* del;
+
+    fifoEpochEnter();
+    while (true) 
+    {
+        del = skipLocatePreds(list, rank, seq, preds, succs);
+        atomic_store_explicit(&node->next[0], (uintptr_t) succs[0], memory_order_relaxed);
+        uintptr_t expected = (uintptr_t) succs[0];
+        if (atomic_compare_exchange_strong(&preds[0]->next[0], &expected, (uintptr_t) node)) break;
+    } //linking on level 0 is the linearization point
+
+    for (int i = 1; i < level; ) 
+    {
+        atomic_store_explicit(&node->next[i], (uintptr_t) succs[i], memory_order_relaxed);
+        if (MARKED(atomic_load(&node->next[0])) || MARKED(atomic_load(&succs[i]->next[0])) || del == succs[i]) break;
+        //node or its successor already deleted: stop building the tower
+
+        uintptr_t expected = (uintptr_t) succs[i];
+        if (atomic_compare_exchange_strong(&preds[i]->next[i], &expected, (uintptr_t) node)) i++;
+        else 
+        {
+            del = skipLocatePreds(list, rank, seq, preds, succs);
+            if (succs[0] != node) break; //node was deleted meanwhile
+        }
+    }
+    atomic_store(&node->inserting, false);
+    fifoEpochExit();
+    
+    return 0;
+}
+
+//Moves the head's upper-level pointers past the deleted prefix
+static void skipRestructure(fifo_skiplist_t* list) 
+{
+    fifo_skip_node_t* pred = list->head;
+    for (int i = SKIP_LEVELS - 1; i > 0; ) 
+    {
+        uintptr_t h = atomic_load(&list->head->next[i]);
+        fifo_skip_node_t* cur = UNMARK(atomic_load(&pred->next[i]));
+        if (!MARKED(atomic_load(&UNMARK(h)->next[0]))) 
+        {
+            i--;
+            continue;
+        }
+        while (MARKED(atomic_load(&cur->next[0]))) 
+        {
+            pred = cur;
+            cur = UNMARK(atomic_load(&pred->next[i]));
+        }
+        if (atomic_compare_exchange_strong(&list->head->next[i], &h, atomic_load(&pred->next[i]))) i--;
+    }
+}
+
+static bool skipDeleteMin(fifo_skiplist_t* list, void** data_out) 
+{
+    fifo_skip_node_t* x = list->head;
+    fifo_skip_node_t* newhead = NULL;
+    uintptr_t obshead;
+    uintptr_t nxt;
+    int offset = 0;
+
+    fifoEpochEnter();
+    obshead = atomic_load(&x->next[0]);
+    do 
+    {
+        nxt = atomic_load(&x->next[0]);
+        if (UNMARK(nxt) == list->tail) 
+        {
+            fifoEpochExit();
+            return false;
+        } //only deleted nodes, if any, before the tail
+        if (newhead == NULL && atomic_load(&x->inserting)) newhead = x;
+        if (!MARKED(nxt)) nxt = atomic_fetch_or(&x->next[0], 1); //claim the successor
+        offset++;
+        x = UNMARK(nxt);
+    } while (MARKED(nxt)); //already marked: someone else owns that node; keep walking
+
+    *data_out = x->data;
+    
+    if (offset >= FIFO_SKIPLIST_BOUND) 
+    {
+        if (newhead == NULL) newhead = x;
+        uintptr_t expected = obshead;
+        if (atomic_compare_exchange_strong(&list->head->next[0], &expected, MARK(newhead))) 
+        {
+            skipRestructure(list);
+            fifo_skip_node_t* cur = UNMARK(obshead);
+            while (cur != newhead) 
+            {
+                fifo_skip_node_t* next = UNMARK(atomic_load(&cur->next[0]));
+                fifoEpochRetire(cur, free);
+                cur = next;
+            }
+        } //unlink the whole deleted prefix with one CAS; stragglers are cleaned up by a later pull
+    }
+    fifoEpochExit();
+    
+    return true;
+}
+
+int fifoSkipPush(fifo_buffer_t* buffer, void* data, int priority, bool blocking) 
+{
+    fifo_skiplist_t* list = buffer->impl.skip;
+
+    while (atomic_fetch_add(&list->reserved, 1) >= buffer->max_buffer_size) 
+    {
+        atomic_fetch_sub(&list->reserved, 1);
+        if (!blocking) return -1;
+
+        unsigned seq = fifoCondEnterWait(&buffer->cond_nonfull);
+        if (atomic_load(&list->reserved) >= buffer->max_buffer_size) fifoFutexWait(&buffer->cond_nonfull.seq, seq);
+        fifoCondLeaveWait(&buffer->cond_nonfull);
+    } //claim capacity first so the bound holds however many pushes race
+
+    int status = skipInsert(list, data, priority);
+    if (status != 0) 
+    {
+        atomic_fetch_sub(&list->reserved, 1);
+        return status;
+    }
+    fifoCondNotify(&buffer->cond_nonempty);
+    return 0;
+}
+
+void* fifoSkipPull(fifo_buffer_t* buffer, bool blocking) 
+{
+    fifo_skiplist_t* list = buffer->impl.skip;
+    void* data = NULL;
+    bool found = skipDeleteMin(list, &data);
+
+    while (!found && blocking) 
+    {
+        unsigned seq = fifoCondEnterWait(&buffer->cond_nonempty);
+        found = skipDeleteMin(list, &data);
+        if (!found) fifoFutexWait(&buffer->cond_nonempty.seq, seq);
+        fifoCondLeaveWait(&buffer->cond_nonempty);
+    } //recheck after announcing ourselves so a concurrent push cannot be missed
+    if (!found) return NULL;
+
+    atomic_fetch_sub(&list->reserved, 1);
+    fifoCondNotify(&buffer->cond_nonfull);
+    return data;
+}
+
+void** fifoSkipFlush(fifo_buffer_t* buffer) 
+{
+    fifo_skiplist_t* list = buffer->impl.skip;
+    int capacity = atomic_load(&list->reserved) + 1, count = 0;
+    void** out = (void**) malloc((capacity + 1) * sizeof(void*));
+    if (out == NULL) return NULL;
+
+    void* data;
+    while (count < capacity && skipDeleteMin(list, &data)) out[count++] = data;
+    out[count] = NULL;
+    
+    atomic_fetch_sub(&list->reserved, count);
+    fifoCondBroadcast(&buffer->cond_nonfull);
+    return out;
+}
+
+int fifoSkipSnapshot(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries, int* occupancy) 
+{
+    fifo_skiplist_t* list = buffer->impl.skip;
+    int count = 0;
+
+    fifoEpochEnter();
+    fifo_skip_node_t* x = list->head;
+    while (count < max_entries) 
+    {
+        uintptr_t nxt = atomic_load(&x->next[0]);
+        fifo_skip_node_t* cur = UNMARK(nxt);
+        if (cur == list->tail) break;
+        if (!MARKED(nxt)) 
+        {
+            entries[count].position = count;
+            entries[count].priority = cur->priority;
+            entries[count].age_ns = 0;
+            entries[count].data = cur->data;
+            count++;
+        } //unmarked pointer: cur is live
+        x = cur;
+    } //lock-free walk of level 0
+    fifoEpochExit();
+
+    *occupancy = atomic_load(&list->reserved);
+    return count;
+}
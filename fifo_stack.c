@@ -0,0 +1,144 @@
+/**
+ * Description: Lock-free LIFO backend (FIFO_BACKEND_STACK), a Treiber stack. A push links a
+ *  new node above the top with one CAS and a pull swings the top to the next node with one
+ *  CAS, so the most recently pushed item, the one most likely still in cache, is served
+ *  first. Priorities are ignored. Pulled nodes are released through epoch-based reclamation,
+ *  which also rules out the ABA problem: a node cannot be reused while a pull that read it
+ *  as the top is still in its critical section.
+ *
+ *  Capacity and blocking use a reserved counter and the lock-free wait protocol, as in the
+ *  skip-list backend.
+ **/
+#include "fifo_internal.h"
+#include "fifo_epoch.h"
+
+typedef struct StackNode {
+    struct StackNode* next;
+    void* data;
+} fifo_stack_node_t;
+
+typedef struct Stack {
+    _Atomic(fifo_stack_node_t*) top __attribute__((aligned(64)));
+    atomic_int reserved __attribute__((aligned(64)));   //elements on the stack, for capacity
+} fifo_stack_t;
+
+struct Stack* fifoStackCreate(void) 
+{
+    fifo_stack_t* stack;
+    if (posix_memalign((void**) &stack, 64, sizeof(fifo_stack_t)) != 0) return NULL;
+    atomic_init(&stack->top, NULL);
+    atomic_init(&stack->reserved, 0);
+    return stack;
+}
+
+void fifoStackDestroy(struct Stack* stack) 
+{
+    fifo_stack_node_t* p = atomic_load(&stack->top);
+    while (p != NULL) 
+    {
+        fifo_stack_node_t* next = p->next;
+        free(p);
+        p = next;
+    }
+    free(stack);
+}
+
+static bool stackPop(fifo_stack_t* stack, void** data_out) 
+{
+    fifoEpochEnter();
+    fifo_stack_node_t* top = atomic_load_explicit(&stack->top, memory_order_acquire);
+    while (top != NULL && !atomic_compare_exchange_weak_explicit(&stack->top, &top, top->next, memory_order_acquire, memory_order_acquire)) ;
+    if (top == NULL) 
+    {
+        fifoEpochExit();
+        return false;
+    }
+    *data_out = top->data;
+    fifoEpochRetire(top, free); //other pulls may still be reading top->next
+    fifoEpochExit();
+    return true;
+}
+
+int fifoStackPush(fifo_buffer_t* buffer, void* data, bool blocking) 
+{
+    fifo_stack_t* stack = buffer->impl.stack;
+
+    while (atomic_fetch_add(&stack->reserved, 1) >= buffer->max_buffer_size) 
+    {
+        atomic_fetch_sub(&stack->reserved, 1);
+        if (!blocking) return -1;
+
+        unsigned seq = fifoCondEnterWait(&buffer->cond_nonfull);
+        if (atomic_load(&stack->reserved) >= buffer->max_buffer_size) fifoFutexWait(&buffer->cond_nonfull.seq, seq);
+        fifoCondLeaveWait(&buffer->cond_nonfull);
+    } //claim capacity first so the bound holds however many pushes race
+
+    fifo_stack_node_t* node = (fifo_stack_node_t*) malloc(sizeof(fifo_stack_node_t));
+    if (node == NULL) 
+    {
+        atomic_fetch_sub(&stack->reserved, 1);
+        return ENOMEM;
+    }
+    node->data = data;
+    node->next = atomic_load_explicit(&stack->top, memory_order_relaxed);
+    while (!atomic_compare_exchange_weak_explicit(&stack->top, &node->next, node, memory_order_release, memory_order_relaxed)) ;
+
+    fifoCondNotify(&buffer->cond_nonempty);
+    return 0;
+}
+
+void* fifoStackPull(fifo_buffer_t* buffer, bool blocking) 
+{
+    fifo_stack_t* stack = buffer->impl.stack;
+    void* data = NULL;
+    bool found = stackPop(stack, &data);
+
+    while (!found && blocking) 
+    {
+        unsigned seq = fifoCondEnterWait(&buffer->cond_nonempty);
+        found = stackPop(stack, &data);
+        if (!found) fifoFutexWait(&buffer->cond_nonempty.seq, seq);
+        fifoCondLeaveWait(&buffer->cond_nonempty);
+    } //recheck after announcing ourselves so a concurrent push cannot be missed
+    if (!found) return NULL;
+
+    atomic_fetch_sub(&stack->reserved, 1);
+    fifoCondNotify(&buffer->cond_nonfull);
+    return data;
+}
+
+void** fifoStackFlush(fifo_buffer_t* buffer) 
+{
+    fifo_stack_t* stack = buffer->impl.stack;
+    int capacity = atomic_load(&stack->reserved) + 1, count = 0;
+    void** out = (void**) malloc((capacity + 1) * sizeof(void*));
+    if (out == NULL) return NULL;
+
+    void* data;
+    while (count < capacity && stackPop(stack, &data)) out[count++] = data;
+    out[count] = NULL;
+
+    atomic_fetch_sub(&stack->reserved, count);
+    fifoCondBroadcast(&buffer->cond_nonfull);
+    return out;
+}
+
+int fifoStackSnapshot(fifo_buffer_t* buffer, fifo_snapshot_entry_t* entries, int max_entries, int* occupancy) 
+{
+    fifo_stack_t* stack = buffer->impl.stack;
+    int count = 0;
+
+    fifoEpochEnter();
+    for (fifo_stack_node_t* p = atomic_load_explicit(&stack->top, memory_order_acquire); p != NULL && count < max_entries; p = p->next) 
+    {
+        entries[count].position = count;
+        entries[count].priority = 0;
+        entries[count].age_ns = 0;
+        entries[count].data = p->data;
+        count++;
+    } //nodes seen here are not freed before fifoEpochExit, though the walk may race with pulls
+    fifoEpochExit();
+
+    *occupancy = atomic_load(&stack->reserved);
+    return count;
+}
@@ -0,0 +1,154 @@
+/**
+ * Description: Strand executor. See fifo_strand.h
+ *  The executor counts scheduled strands, i.e. strands in the run queue or being run. The
+ *  count changes once per strand activation, not per task, and reaching zero means every
+ *  posted task has run, which is what fifoExecutorDestroy waits for. Workers stop when they
+ *  pull a NULL strand.
+ **/
+#include "fifo_strand.h"
+#include "fifo.h"
+#include <limits.h>
+#include <sched.h>
+
+typedef struct StrandTask {
+    fifo_mailbox_node_t link;
+    void (*fn)(void*);
+    void* arg;
+} fifo_strand_task_t;
+
+typedef struct Executor {
+    fifo_buffer_t* run_queue;       //strands ready to run
+    atomic_int scheduled;           //strands in the run queue or running
+    fifo_cond_t idle;               //notified when scheduled drops to 0
+    int threads;
+    pthread_t* workers;
+    int keyed_count;
+    fifo_strand_t* keyed;
+} fifo_executor_t;
+
+static uint64_t strandHash(uint64_t key) 
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    return key ^ (key >> 33);
+} //murmur3 finalizer
+
+static void* strandWorker(void* arg) 
+{
+    fifo_executor_t* executor = (fifo_executor_t*) arg;
+    for (;;) 
+    {
+        fifo_strand_t* strand = (fifo_strand_t*) fifoPull(executor->run_queue, true);
+        if (strand == NULL) return NULL;
+
+        while (strand != NULL) 
+        {
+            for (int i = 0; i < FIFO_STRAND_BATCH; i++) 
+            {
+                fifo_mailbox_node_t* node = fifoMailboxPop(&strand->mailbox);
+                if (node == NULL) break;
+                fifo_strand_task_t* task = fifoMailboxEntry(node, fifo_strand_task_t, link);
+                task->fn(task->arg);
+                free(task);
+            }
+
+            if (!fifoMailboxRelease(&strand->mailbox)) 
+            {
+                if (atomic_fetch_sub(&executor->scheduled, 1) == 1) fifoCondNotify(&executor->idle);
+                strand = NULL;
+            }
+            else if (fifoPush(executor->run_queue, strand, 0, true) == 0) strand = NULL; //more tasks: back of the queue
+            //requeue failed: the strand is still ours and still scheduled, so run its next batch here
+        }
+    }
+}
+
+fifo_executor_t* fifoExecutorCreate(int threads, int keyed_strands) 
+{
+    if (threads <= 0 || keyed_strands < 0) return NULL;
+    fifo_executor_t* executor = (fifo_executor_t*) calloc(1, sizeof(fifo_executor_t));
+    if (executor == NULL) return NULL;
+    atomic_init(&executor->scheduled, 0);
+    fifoCondInit(&executor->idle);
+
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    if (attr.lock_kind == FIFO_LOCK_NONE) attr.lock_kind = FIFO_LOCK_NORMAL; //shared by every worker and poster
+    attr.handoff = true;
+    executor->run_queue = fifoBufferInitAttr(INT_MAX, NULL, &attr); //a strand is queued at most once, so never full in practice
+    executor->workers = (pthread_t*) malloc((unsigned) threads * sizeof(pthread_t));
+    if (keyed_strands > 0) executor->keyed = (fifo_strand_t*) malloc((unsigned) keyed_strands * sizeof(fifo_strand_t));
+    if (executor->run_queue == NULL || executor->workers == NULL || (keyed_strands > 0 && executor->keyed == NULL)) 
+    {
+        if (executor->run_queue != NULL) free(fifoBufferClose(executor->run_queue));
+        free(executor->workers);
+        free(executor->keyed);
+        free(executor);
+        return NULL;
+    }
+
+    executor->keyed_count = keyed_strands;
+    for (int i = 0; i < keyed_strands; i++) fifoStrandInit(&executor->keyed[i], executor);
+
+    for (executor->threads = 0; executor->threads < threads; executor->threads++) 
+    {
+        if (pthread_create(&executor->workers[executor->threads], NULL, strandWorker, executor) != 0) 
+        {
+            fifoExecutorDestroy(executor);
+            return NULL;
+        }
+    }
+    return executor;
+}
+
+void fifoExecutorDestroy(fifo_executor_t* executor) 
+{
+    for (;;) 
+    {
+        unsigned seq = fifoCondEnterWait(&executor->idle);
+        bool busy = atomic_load(&executor->scheduled) != 0;
+        if (busy) fifoFutexWait(&executor->idle.seq, seq);
+        fifoCondLeaveWait(&executor->idle);
+        if (!busy) break;
+    } //strands that run out of tasks decrement scheduled; the last one wakes us
+
+    for (int i = 0; i < executor->threads; i++) 
+    {
+        while (fifoPush(executor->run_queue, NULL, 0, true) != 0) sched_yield();
+    } //one stop marker per worker; a lost one would leave its worker unjoinable
+    for (int i = 0; i < executor->threads; i++) pthread_join(executor->workers[i], NULL);
+
+    free(fifoBufferClose(executor->run_queue));
+    free(executor->workers);
+    free(executor->keyed);
+    free(executor);
+}
+
+void fifoStrandInit(fifo_strand_t* strand, fifo_executor_t* executor) 
+{
+    fifoMailboxInit(&strand->mailbox);
+    strand->executor = executor;
+}
+
+int fifoStrandPost(fifo_strand_t* strand, void (*fn)(void*), void* arg) 
+{
+    fifo_strand_task_t* task = (fifo_strand_task_t*) malloc(sizeof(fifo_strand_task_t));
+    if (task == NULL) return ENOMEM;
+    task->fn = fn;
+    task->arg = arg;
+
+    if (!fifoMailboxPush(&strand->mailbox, &task->link)) return 0; //queued or running: the worker will see it
+
+    fifo_executor_t* executor = strand->executor;
+    atomic_fetch_add(&executor->scheduled, 1);
+    while (fifoPush(executor->run_queue, strand, 0, true) != 0) sched_yield();
+    return 0; //the task is in the mailbox and cannot be taken back: the strand must be queued
+}
+
+int fifoExecutorPost(fifo_executor_t* executor, uint64_t key, void (*fn)(void*), void* arg) 
+{
+    if (executor->keyed_count == 0) return EINVAL;
+    return fifoStrandPost(&executor->keyed[strandHash(key) % (uint64_t) executor->keyed_count], fn, arg);
+}
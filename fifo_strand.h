@@ -0,0 +1,50 @@
+/**
+ * Description: Strand executor. A pool of worker threads runs tasks posted to strands: tasks
+ *  of one strand run one at a time in post order, tasks of different strands run in parallel.
+ *  A strand is a fifo_mailbox_t plus a pointer, so an application can keep one per connection
+ *  or per session instead of one fifo_buffer_t each.
+ *
+ *  A strand enters the executor's run queue, an ordinary fifo_buffer_t of strands, only when a
+ *  post finds it idle; posts to a strand that is already queued or running are a wait-free
+ *  mailbox push and take no lock. A worker pulls a strand, runs up to FIFO_STRAND_BATCH of its
+ *  tasks and releases it, requeuing it at the back if more tasks arrived. Workers parked on
+ *  an empty run queue receive the next strand by direct hand-off (fifo_attr_t.handoff).
+ *
+ *  Keyed posts map a 64-bit key onto one of a fixed set of strands owned by the executor, so
+ *  tasks with equal keys are serialized without the caller managing strands; distinct keys
+ *  that share a strand are serialized too.
+ **/
+
+#ifndef _FIFO_STRAND_H_
+#define _FIFO_STRAND_H_
+
+    #include <stdint.h>
+    #include "fifo_mailbox.h"
+
+    typedef struct Executor fifo_executor_t; //defined in fifo_strand.c
+
+    typedef struct Strand {
+        fifo_mailbox_t mailbox;
+        fifo_executor_t* executor;
+    } fifo_strand_t;
+
+    //Starts threads workers and keyed_strands strands for fifoExecutorPost (0 for none).
+    //Returns NULL on failure
+    fifo_executor_t* fifoExecutorCreate(int threads, int keyed_strands);
+
+    //Waits until every posted task has run, then stops the workers and frees the executor.
+    //No post may race with this call
+    void fifoExecutorDestroy(fifo_executor_t* executor);
+
+    //Binds strand to executor. A strand needs no destructor and may be freed once its last
+    //task has returned
+    void fifoStrandInit(fifo_strand_t* strand, fifo_executor_t* executor);
+
+    //Queues fn(arg) on strand. Returns 0, or ENOMEM if the task could not be allocated. Once
+    //queued a task always runs: a strand the run queue refuses is retried, never dropped
+    int fifoStrandPost(fifo_strand_t* strand, void (*fn)(void*), void* arg);
+
+    //Queues fn(arg) on the executor's strand for key. Returns 0, ENOMEM, or EINVAL if the
+    //executor has no keyed strands
+    int fifoExecutorPost(fifo_executor_t* executor, uint64_t key, void (*fn)(void*), void* arg);
+#endif
@@ -0,0 +1,73 @@
+/**
+ * Description: Calendar backend against the list backend as a discrete-event simulator's
+ *  event set, using the classic hold model: with FIFO_BENCH_EVENTS (default 10^6) events
+ *  pending, each hold pulls the earliest event and schedules a new one a random time later.
+ *  The list serves the highest priority first, so it gets priority INT_MAX - time. Its
+ *  insert scans the list, which makes a hold linear in the pending count, so the list runs
+ *  only FIFO_BENCH_LIST_HOLDS (default 1000) holds against the calendar's
+ *  FIFO_BENCH_CAL_HOLDS (default 10^6). Both are filled in time order, an O(1) insert for
+ *  either backend, and the fill is not timed.
+ **/
+#include "test_common.h"
+#include "../fifo.h"
+#include <limits.h>
+
+#define MEAN_GAP 100 //mean time between pending events
+
+static uint64_t rng = 88172645463325252ull;
+
+static uint64_t nextRandom(void) 
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return rng;
+}
+
+//Fills buffer with events events in time order, then times holds holds. Returns ns per hold
+static double holdModel(fifo_backend_t backend, long events, long holds) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = backend;
+    fifo_buffer_t* buffer = fifoBufferInitAttr((int) events + 1, NULL, &attr);
+    CHECK(buffer != NULL);
+
+    uint64_t time = 0;
+    for (long i = 0; i < events; i++) 
+    {
+        time += nextRandom() % (2 * MEAN_GAP);
+        if (backend == FIFO_BACKEND_CALENDAR) CHECK(fifoPushKey(buffer, (void*) (uintptr_t) (time + 1), time, false) == 0);
+        else CHECK(fifoPush(buffer, (void*) (uintptr_t) (time + 1), INT_MAX - (int) time, false) == 0);
+    }
+
+    uint64_t last = 0;
+    uint64_t start = testNowNs();
+    for (long i = 0; i < holds; i++) 
+    {
+        uint64_t now = (uint64_t) (uintptr_t) fifoPull(buffer, false) - 1;
+        CHECK(now >= last);
+        last = now;
+        uint64_t next = now + nextRandom() % (2 * MEAN_GAP * (uint64_t) events);
+        CHECK(next < INT_MAX);
+        if (backend == FIFO_BACKEND_CALENDAR) CHECK(fifoPushKey(buffer, (void*) (uintptr_t) (next + 1), next, false) == 0);
+        else CHECK(fifoPush(buffer, (void*) (uintptr_t) (next + 1), INT_MAX - (int) next, false) == 0);
+    }
+    double per_hold = (double) (testNowNs() - start) / (double) holds;
+
+    free(fifoBufferClose(buffer));
+    return per_hold;
+}
+
+int main(void) 
+{
+    long events = testEnvLong("FIFO_BENCH_EVENTS", 1000000);
+    long cal_holds = testEnvLong("FIFO_BENCH_CAL_HOLDS", 1000000);
+    long list_holds = testEnvLong("FIFO_BENCH_LIST_HOLDS", 1000);
+
+    double cal = holdModel(FIFO_BACKEND_CALENDAR, events, cal_holds);
+    double list = holdModel(FIFO_BACKEND_LIST, events, list_holds);
+    printf("bench_calendar: %ld pending events, calendar %.0f ns/hold (%ld holds), list %.0f ns/hold (%ld holds), %.0fx\n", 
+        events, cal, cal_holds, list, list_holds, list / cal);
+    return 0;
+}
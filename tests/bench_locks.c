@@ -0,0 +1,66 @@
+/**
+ * Description: Push/pull throughput of the list backend under every lock kind. Each round
+ *  runs FIFO_BENCH_THREADS threads (default 4, and 1 for the uncontended cost) that each do
+ *  FIFO_BENCH_OPS (default 200000) non-blocking push+pull pairs on one shared buffer.
+ *  Combining is off so every operation goes through the lock. FIFO_LOCK_NONE is only run
+ *  single-threaded, as the floor the others are measured against.
+ **/
+#include "test_common.h"
+#include "../fifo.h"
+#include <pthread.h>
+
+static fifo_buffer_t* buffer;
+static long ops;
+
+static void* worker(void* arg) 
+{
+    intptr_t id = (intptr_t) arg;
+    for (long i = 0; i < ops; i++) 
+    {
+        fifoPush(buffer, (void*) (id + 1), (int) (i & 3), false);
+        fifoPull(buffer, false);
+    }
+    return NULL;
+}
+
+//Returns ns per push+pull pair over all threads
+static double benchRound(fifo_lock_kind_t kind, int threads) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.lock_kind = kind;
+    attr.combining = false;
+    buffer = fifoBufferInitAttr(1024, NULL, &attr);
+    CHECK(buffer != NULL);
+
+    pthread_t ids[threads];
+    uint64_t start = testNowNs();
+    if (threads == 1) worker(NULL); //on the creating thread, which FIFO_LOCK_NONE requires
+    else 
+    {
+        for (intptr_t i = 0; i < threads; i++) CHECK(pthread_create(&ids[i], NULL, worker, (void*) i) == 0);
+        for (int i = 0; i < threads; i++) pthread_join(ids[i], NULL);
+    }
+    double per_pair = (double) (testNowNs() - start) / (double) (ops * threads);
+
+    free(fifoBufferClose(buffer));
+    return per_pair;
+}
+
+int main(void) 
+{
+    int threads = (int) testEnvLong("FIFO_BENCH_THREADS", 4);
+    ops = testEnvLong("FIFO_BENCH_OPS", 200000);
+    fifo_lock_kind_t kinds[] = { FIFO_LOCK_ERRORCHECK, FIFO_LOCK_NORMAL, FIFO_LOCK_ADAPTIVE, FIFO_LOCK_SPIN, 
+        FIFO_LOCK_TICKET, FIFO_LOCK_MCS, FIFO_LOCK_COHORT, FIFO_LOCK_PI };
+
+    printf("bench_locks: ns per push+pull pair, %ld pairs per thread\n", ops);
+    printf("  %-12s %10s %10s\n", "lock", "1 thread", "contended");
+    printf("  %-12s %10.0f %10s\n", fifoLockKindName(FIFO_LOCK_NONE), benchRound(FIFO_LOCK_NONE, 1), "-");
+    for (size_t k = 0; k < sizeof(kinds) / sizeof(kinds[0]); k++) 
+    {
+        double single = benchRound(kinds[k], 1);
+        printf("  %-12s %10.0f %10.0f\n", fifoLockKindName(kinds[k]), single, benchRound(kinds[k], threads));
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * Description: fifoPushBatch: single-threaded pull order against the same items pushed one by
+ *  one, for random priorities with negatives and ties merged into a non-empty buffer; a batch
+ *  is queued whole or not at all, and its leading items go to consumers parked on the empty
+ *  buffer; then exactly-once delivery and per-producer order with concurrent batch producers
+ *  and consumers polling or parked.
+ **/
+#include "test_stress.h"
+#include <unistd.h>
+
+#define BATCH 64
+#define ROUNDS 200
+
+static void checkBatchMatchesSequential(void) 
+{
+    fifo_buffer_t* batched = fifoBufferInit(ROUNDS * BATCH, NULL);
+    fifo_buffer_t* sequential = fifoBufferInit(ROUNDS * BATCH, NULL);
+    CHECK(batched != NULL && sequential != NULL);
+
+    unsigned rng = 777;
+    void* data[BATCH];
+    int priorities[BATCH];
+    for (int round = 0; round < ROUNDS; round++) 
+    {
+        int count = 1 + round % BATCH;
+        for (int i = 0; i < count; i++) 
+        {
+            rng = rng * 1103515245 + 12345;
+            data[i] = (void*) (intptr_t) (round * BATCH + i + 1);
+            priorities[i] = (int) ((rng >> 16) % 12) - 2;
+            CHECK(fifoPush(sequential, data[i], priorities[i], false) == 0);
+        }
+        CHECK(fifoPushBatch(batched, data, priorities, count, false) == 0);
+        for (int i = 0; i < count / 2; i++) CHECK(fifoPull(batched, false) == fifoPull(sequential, false));
+    }
+    void* item;
+    while ((item = fifoPull(sequential, false)) != NULL) CHECK(fifoPull(batched, false) == item);
+    CHECK(fifoPull(batched, false) == NULL);
+
+    free(fifoBufferClose(batched));
+    free(fifoBufferClose(sequential));
+}
+
+static fifo_buffer_t* shared;
+
+static void* pushThree(void* arg) 
+{
+    void* data[3] = { (void*) 7, (void*) 8, (void*) 9 };
+    (void) arg;
+    CHECK(fifoPushBatch(shared, data, NULL, 3, true) == 0);
+    return NULL;
+}
+
+static void* pullOne(void* arg) 
+{
+    (void) arg;
+    return fifoPull(shared, true);
+}
+
+//A batch that does not fit is refused whole, or waits until all of it fits
+static void checkAllOrNothing(void) 
+{
+    shared = fifoBufferInit(8, NULL);
+    CHECK(shared != NULL);
+    for (intptr_t i = 1; i <= 6; i++) CHECK(fifoPush(shared, (void*) i, 0, false) == 0);
+    void* data[3] = { (void*) 7, (void*) 8, (void*) 9 };
+    CHECK(fifoPushBatch(shared, data, NULL, 3, false) == -1);
+
+    pthread_t id;
+    CHECK(pthread_create(&id, NULL, pushThree, NULL) == 0);
+    usleep(20000);
+    CHECK(fifoPull(shared, true) == (void*) 1); //room for all three now
+    pthread_join(id, NULL);
+    for (intptr_t i = 2; i <= 9; i++) CHECK(fifoPull(shared, false) == (void*) i);
+    CHECK(fifoPull(shared, false) == NULL);
+    free(fifoBufferClose(shared));
+}
+
+//Consumers parked on the empty buffer take the leading items, as sequential pushes would give them
+static void checkParkedConsumers(void) 
+{
+    shared = fifoBufferInit(8, NULL);
+    CHECK(shared != NULL);
+    pthread_t ids[2];
+    for (int i = 0; i < 2; i++) CHECK(pthread_create(&ids[i], NULL, pullOne, NULL) == 0);
+    usleep(20000); //let them park; the outcome is the same if they have not yet
+
+    void* data[5] = { (void*) 1, (void*) 2, (void*) 3, (void*) 4, (void*) 5 };
+    CHECK(fifoPushBatch(shared, data, NULL, 5, false) == 0);
+    intptr_t got = 0;
+    for (int i = 0; i < 2; i++) 
+    {
+        void* item;
+        pthread_join(ids[i], &item);
+        got += (intptr_t) item;
+    }
+    CHECK(got == 1 + 2);
+    for (intptr_t i = 3; i <= 5; i++) CHECK(fifoPull(shared, false) == (void*) i);
+    CHECK(fifoPull(shared, false) == NULL);
+    free(fifoBufferClose(shared));
+}
+
+int main(void) 
+{
+    long per_producer = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    checkBatchMatchesSequential();
+    checkAllOrNothing();
+    checkParkedConsumers();
+
+    fifo_buffer_t* buffer = fifoBufferInit(4 * BATCH, "batch");
+    CHECK(buffer != NULL);
+    void* oversized[4 * BATCH + 1] = { 0 };
+    CHECK(fifoPushBatch(buffer, oversized, NULL, 4 * BATCH + 1, true) == -1); //could never fit
+
+    testStressBatched(buffer, 1, 1, per_producer, true, BATCH);
+    testStressBatched(buffer, 4, 4, per_producer, true, BATCH);
+    testStressRun(buffer, 4, 4, per_producer, true, BATCH, true);
+
+    free(fifoBufferClose(buffer));
+    printf("test_batch: ok\n");
+    return 0;
+}
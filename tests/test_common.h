@@ -0,0 +1,36 @@
+/**
+ * Description: Helpers shared by the tests and benchmarks under tests/. Each program is a
+ *  standalone executable linked against libfifo.a; it prints one summary line and exits
+ *  non-zero on the first failed CHECK.
+ **/
+
+#ifndef _FIFO_TEST_COMMON_H_
+#define _FIFO_TEST_COMMON_H_
+
+    #include <stdio.h>
+    #include <stdlib.h>
+    #include <stdint.h>
+    #include <time.h>
+
+    #define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+    static inline uint64_t testNowNs(void) 
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+
+    //Reads an integer tuning knob from the environment, e.g. to shrink a run on a slow machine
+    static inline long testEnvLong(const char* name, long fallback) 
+    {
+        const char* value = getenv(name);
+        return value != NULL ? strtol(value, NULL, 10) : fallback;
+    }
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * Description: FIFO_BACKEND_FAA: strict first-in first-out order through pulls, flush and
+ *  snapshot across many array segments, no capacity limit, then exactly-once delivery and
+ *  per-producer order under concurrent producers and consumers, polling and parked on the
+ *  futex. Segments recycled by the first buffer are reused by the next.
+ **/
+#include "test_stress.h"
+
+#define SPAN (3 * FIFO_FAA_SEGMENT_SIZE + 5)   //items spread over four segments
+
+static fifo_buffer_t* faaBuffer(const char* name) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = FIFO_BACKEND_FAA;
+    fifo_buffer_t* buffer = fifoBufferInitAttr(16, name, &attr); //capacity is not enforced
+    CHECK(buffer != NULL);
+    return buffer;
+}
+
+//Pulls, snapshot and flush must all see push order, also across segment boundaries
+static void checkSegmentOrder(void) 
+{
+    fifo_buffer_t* buffer = faaBuffer(NULL);
+    for (intptr_t i = 1; i <= SPAN; i++) CHECK(fifoPush(buffer, (void*) i, (int) i % 7 - 3, false) == 0); //priorities are ignored
+    for (intptr_t i = 1; i <= FIFO_FAA_SEGMENT_SIZE + 1; i++) CHECK(fifoPull(buffer, false) == (void*) i);
+
+    fifo_snapshot_t snap;
+    fifo_snapshot_entry_t entries[8];
+    CHECK(fifoSnapshot(buffer, &snap, entries, 8, true) == 0);
+    CHECK(snap.occupancy == SPAN - FIFO_FAA_SEGMENT_SIZE - 1 && snap.count == 8);
+    for (int i = 0; i < 8; i++) CHECK(entries[i].data == (void*) (intptr_t) (FIFO_FAA_SEGMENT_SIZE + 2 + i));
+
+    void** out = fifoFlush(buffer, true);
+    CHECK(out != NULL);
+    intptr_t expected = FIFO_FAA_SEGMENT_SIZE + 2;
+    for (int i = 0; out[i] != NULL; i++) CHECK(out[i] == (void*) expected++);
+    CHECK(expected == SPAN + 1);
+    free(out);
+    CHECK(fifoPull(buffer, false) == NULL);
+
+    for (intptr_t i = 1; i <= SPAN; i++) CHECK(fifoPush(buffer, (void*) i, 0, false) == 0);
+    out = fifoBufferClose(buffer); //drained segments go to the spare pool for the next buffer
+    CHECK(out != NULL);
+    expected = 1;
+    for (int i = 0; out[i] != NULL; i++) CHECK(out[i] == (void*) expected++);
+    CHECK(expected == SPAN + 1);
+    free(out);
+}
+
+int main(void) 
+{
+    long per_producer = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    checkSegmentOrder();
+
+    fifo_buffer_t* buffer = faaBuffer("faa");
+    testStress(buffer, 1, 1, per_producer, true);
+    testStress(buffer, 4, 4, per_producer, true);
+    testStressBlocking(buffer, 4, 4, per_producer, true);
+    CHECK(fifoPush(buffer, NULL, 0, false) != 0); //NULL marks an unfilled cell
+
+    free(fifoBufferClose(buffer));
+    printf("test_faa: ok\n");
+    return 0;
+}
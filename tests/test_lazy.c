@@ -0,0 +1,107 @@
+/**
+ * Description: Lazy priority ordering (fifo_attr_t.lazy_threshold): for several thresholds, a
+ *  lazy buffer must pull, snapshot and flush in exactly the order of an eager one under random
+ *  priorities, negatives and ties, single and batch pushes; then exactly-once delivery and
+ *  per-producer order under concurrent producers and consumers, polling and parked.
+ **/
+#include "test_stress.h"
+
+#define ITEMS 4000
+#define CAPACITY 256
+
+static fifo_buffer_t* lazyBuffer(int threshold, const char* name) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.lazy_threshold = threshold;
+    fifo_buffer_t* buffer = fifoBufferInitAttr(CAPACITY, name, &attr);
+    CHECK(buffer != NULL);
+    return buffer;
+}
+
+static void checkSameSnapshot(fifo_buffer_t* lazy, fifo_buffer_t* eager) 
+{
+    fifo_snapshot_t lazy_snap, eager_snap;
+    fifo_snapshot_entry_t lazy_entries[CAPACITY], eager_entries[CAPACITY];
+    CHECK(fifoSnapshot(lazy, &lazy_snap, lazy_entries, CAPACITY, true) == 0);
+    CHECK(fifoSnapshot(eager, &eager_snap, eager_entries, CAPACITY, true) == 0);
+    CHECK(lazy_snap.count == eager_snap.count && lazy_snap.occupancy == eager_snap.occupancy);
+    for (int i = 0; i < lazy_snap.count; i++) 
+    {
+        CHECK(lazy_entries[i].data == eager_entries[i].data && lazy_entries[i].priority == eager_entries[i].priority);
+    }
+}
+
+static void checkMatchesEager(int threshold) 
+{
+    fifo_buffer_t* lazy = lazyBuffer(threshold, NULL);
+    fifo_buffer_t* eager = lazyBuffer(0, NULL);
+
+    unsigned rng = 31337 + (unsigned) threshold;
+    intptr_t next = 1;
+    while (next <= ITEMS) 
+    {
+        rng = rng * 1103515245 + 12345;
+        unsigned roll = (rng >> 16) % 16;
+        if (roll < 8) 
+        {
+            int priority = (int) ((rng >> 8) % 10) - 2;
+            int status = fifoPush(eager, (void*) next, priority, false);
+            CHECK(fifoPush(lazy, (void*) next, priority, false) == status);
+            next++;
+        }
+        else if (roll < 10) 
+        {
+            void* data[8];
+            int priorities[8];
+            int count = 1 + (int) ((rng >> 4) % 8);
+            for (int i = 0; i < count; i++) 
+            {
+                data[i] = (void*) next++;
+                priorities[i] = (int) ((rng >> i) % 5) - 1;
+            }
+            int status = fifoPushBatch(eager, data, priorities, count, false);
+            CHECK(fifoPushBatch(lazy, data, priorities, count, false) == status);
+        }
+        else if (roll < 15) CHECK(fifoPull(lazy, false) == fifoPull(eager, false));
+        else checkSameSnapshot(lazy, eager);
+    } //the buffers fill up at times, so refused pushes are compared too
+
+    void** lazy_out = fifoFlush(lazy, true);
+    void** eager_out = fifoFlush(eager, true);
+    CHECK(lazy_out != NULL && eager_out != NULL);
+    int i = 0;
+    for (; eager_out[i] != NULL; i++) CHECK(lazy_out[i] == eager_out[i]);
+    CHECK(lazy_out[i] == NULL);
+    free(lazy_out);
+    free(eager_out);
+
+    //Items still staged at close come back in pull order too
+    for (intptr_t d = 1; d <= threshold && d < CAPACITY; d++) 
+    {
+        CHECK(fifoPush(lazy, (void*) d, (int) (d % 3), false) == 0);
+        CHECK(fifoPush(eager, (void*) d, (int) (d % 3), false) == 0);
+    }
+    lazy_out = fifoBufferClose(lazy);
+    eager_out = fifoBufferClose(eager);
+    for (i = 0; eager_out[i] != NULL; i++) CHECK(lazy_out[i] == eager_out[i]);
+    CHECK(lazy_out[i] == NULL);
+    free(lazy_out);
+    free(eager_out);
+}
+
+int main(void) 
+{
+    long per_producer = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    int thresholds[] = { 1, 3, 16, CAPACITY };
+    for (int i = 0; i < 4; i++) checkMatchesEager(thresholds[i]);
+
+    fifo_buffer_t* buffer = lazyBuffer(16, "lazy");
+    testStress(buffer, 1, 1, per_producer, true);
+    testStress(buffer, 4, 4, per_producer, true);
+    testStressBlocking(buffer, 4, 4, per_producer, true);
+
+    free(fifoBufferClose(buffer));
+    printf("test_lazy: ok\n");
+    return 0;
+}
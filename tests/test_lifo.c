@@ -0,0 +1,103 @@
+/**
+ * Description: Last-in first-out pulls: FIFO_BACKEND_STACK serves newest first through pulls,
+ *  snapshot and flush and enforces its capacity; the list backend's FIFO_ORDER_LIFO ignores
+ *  priorities, and FIFO_ORDER_MIXED serves the owner newest first and other threads oldest
+ *  first. Then exactly-once delivery on the stack under concurrent producers and consumers,
+ *  polling and parked; pull order is not checked there, as LIFO has no per-producer order.
+ **/
+#include "test_stress.h"
+
+#define ITEMS 100
+
+static fifo_buffer_t* shared;
+
+static void* pullOnce(void* arg) 
+{
+    (void) arg;
+    return fifoPull(shared, false);
+}
+
+static void checkStackOrder(void) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = FIFO_BACKEND_STACK;
+    fifo_buffer_t* buffer = fifoBufferInitAttr(ITEMS, NULL, &attr);
+    CHECK(buffer != NULL);
+
+    for (intptr_t i = 1; i <= ITEMS; i++) CHECK(fifoPush(buffer, (void*) i, (int) i % 5, false) == 0); //priorities are ignored
+    CHECK(fifoPush(buffer, (void*) 1, 0, false) == -1);
+    for (intptr_t i = ITEMS; i > ITEMS / 2; i--) CHECK(fifoPull(buffer, false) == (void*) i);
+
+    fifo_snapshot_t snap;
+    fifo_snapshot_entry_t entries[4];
+    CHECK(fifoSnapshot(buffer, &snap, entries, 4, true) == 0);
+    CHECK(snap.occupancy == ITEMS / 2 && snap.count == 4);
+    for (int i = 0; i < 4; i++) CHECK(entries[i].data == (void*) (intptr_t) (ITEMS / 2 - i));
+
+    void** out = fifoFlush(buffer, true);
+    CHECK(out != NULL);
+    intptr_t expected = ITEMS / 2;
+    for (int i = 0; out[i] != NULL; i++) CHECK(out[i] == (void*) expected--);
+    CHECK(expected == 0);
+    free(out);
+    CHECK(fifoPull(buffer, false) == NULL);
+    free(fifoBufferClose(buffer));
+}
+
+static void checkListOrders(void) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.pull_order = FIFO_ORDER_LIFO;
+    fifo_buffer_t* lifo = fifoBufferInitAttr(ITEMS, NULL, &attr);
+    attr.pull_order = FIFO_ORDER_MIXED;
+    shared = fifoBufferInitAttr(ITEMS, NULL, &attr);
+    CHECK(lifo != NULL && shared != NULL);
+    fifoBufferSetOwner(shared);
+
+    for (intptr_t i = 1; i <= ITEMS; i++) 
+    {
+        int priority = (int) (i % 7) - 2;
+        CHECK(fifoPush(lifo, (void*) i, priority, false) == 0);
+        CHECK(fifoPush(shared, (void*) i, priority, false) == 0);
+    }
+    for (intptr_t i = ITEMS; i >= 1; i--) CHECK(fifoPull(lifo, false) == (void*) i);
+    CHECK(fifoPull(lifo, false) == NULL);
+
+    //The owner takes from the newest end, any other thread from the oldest
+    for (intptr_t i = 1; i <= ITEMS / 2; i++) 
+    {
+        CHECK(fifoPull(shared, false) == (void*) (ITEMS + 1 - i));
+        pthread_t id;
+        void* stolen;
+        CHECK(pthread_create(&id, NULL, pullOnce, NULL) == 0);
+        pthread_join(id, &stolen);
+        CHECK(stolen == (void*) i);
+    }
+    CHECK(fifoPull(shared, false) == NULL);
+
+    free(fifoBufferClose(lifo));
+    free(fifoBufferClose(shared));
+}
+
+int main(void) 
+{
+    long per_producer = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    checkStackOrder();
+    checkListOrders();
+
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = FIFO_BACKEND_STACK;
+    fifo_buffer_t* buffer = fifoBufferInitAttr(256, "stack", &attr);
+    CHECK(buffer != NULL);
+
+    testStress(buffer, 1, 1, per_producer, false);
+    testStress(buffer, 4, 4, per_producer, false);
+    testStressBlocking(buffer, 4, 4, per_producer, false);
+
+    free(fifoBufferClose(buffer));
+    printf("test_lifo: ok\n");
+    return 0;
+}
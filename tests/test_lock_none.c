@@ -0,0 +1,80 @@
+/**
+ * Description: FIFO_LOCK_NONE buffers on the list, radix and calendar backends: order is the
+ *  same as with a real lock, a blocking push on a full buffer fails at once with EDEADLK
+ *  instead of waiting forever, a non-blocking one with -1, a blocking pull on an empty buffer
+ *  returns NULL, and the buffer stays out of the registry.
+ **/
+#include "test_common.h"
+#include "../fifo.h"
+#include <errno.h>
+#include <string.h>
+
+#define CAPACITY 8
+
+static fifo_buffer_t* unsynchronized(fifo_backend_t backend, const char* name) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = backend;
+    attr.lock_kind = FIFO_LOCK_NONE;
+    attr.handoff = true; //turned off: nobody else could be parked
+    fifo_buffer_t* buffer = fifoBufferInitAttr(CAPACITY, name, &attr);
+    CHECK(buffer != NULL);
+    return buffer;
+}
+
+//Pushes CAPACITY items whose priorities (keys) run against push order, so every backend must reorder them
+static void checkBackend(fifo_backend_t backend) 
+{
+    fifo_buffer_t* buffer = unsynchronized(backend, "unsynchronized");
+    CHECK(fifoPull(buffer, true) == NULL);
+    for (intptr_t i = 1; i <= CAPACITY; i++) 
+    {
+        int priority = backend == FIFO_BACKEND_LIST ? (int) i : CAPACITY + 1 - (int) i; //list: higher first; keyed: smaller first
+        CHECK(fifoPush(buffer, (void*) i, priority, true) == 0);
+    }
+    CHECK(fifoPush(buffer, (void*) 99, 0, false) == -1);
+    CHECK(fifoPush(buffer, (void*) 99, 0, true) == EDEADLK);
+    if (backend == FIFO_BACKEND_LIST) 
+    {
+        void* data[2] = { (void*) 98, (void*) 99 };
+        CHECK(fifoPushBatch(buffer, data, NULL, 2, true) == EDEADLK);
+    }
+
+    for (intptr_t i = CAPACITY; i > CAPACITY / 2; i--) CHECK(fifoPull(buffer, true) == (void*) i);
+    void** out = fifoFlush(buffer, true);
+    CHECK(out != NULL);
+    intptr_t expected = CAPACITY / 2;
+    for (int i = 0; out[i] != NULL; i++) CHECK(out[i] == (void*) expected--);
+    CHECK(expected == 0);
+    free(out);
+    CHECK(fifoPull(buffer, true) == NULL);
+
+    fifo_stats_t stats;
+    CHECK(fifoGetStats(buffer, &stats) == 0);
+    CHECK(stats.handoffs == 0);
+
+    //Registered buffers appear in the dump by name; this one must not
+    fifo_buffer_t* reference = fifoBufferInit(CAPACITY, "locked");
+    CHECK(reference != NULL);
+    char* dump = NULL;
+    size_t dump_len = 0;
+    FILE* stream = open_memstream(&dump, &dump_len);
+    CHECK(stream != NULL);
+    fifoRegistryDump(stream);
+    fclose(stream);
+    CHECK(strstr(dump, "locked") != NULL && strstr(dump, "unsynchronized") == NULL);
+    free(dump);
+    free(fifoBufferClose(reference));
+
+    free(fifoBufferClose(buffer));
+}
+
+int main(void) 
+{
+    checkBackend(FIFO_BACKEND_LIST);
+    checkBackend(FIFO_BACKEND_RADIX);
+    checkBackend(FIFO_BACKEND_CALENDAR);
+    printf("test_lock_none: ok\n");
+    return 0;
+}
@@ -0,0 +1,85 @@
+/**
+ * Description: Mailbox scheduling protocol with several producers and one worker that runs
+ *  small batches, so runs often end with messages left. A push that returns true hands the
+ *  worker a token; a release that returns true hands it back. Every message must be popped
+ *  exactly once in per-producer order, and once all producers are done no message may be
+ *  left behind without a token.
+ **/
+#include "test_common.h"
+#include "../fifo_mailbox.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+
+#define PRODUCERS 4
+#define BATCH 3
+
+typedef struct Message {
+    fifo_mailbox_node_t link;
+    int producer;
+    long seq;
+} message_t;
+
+static fifo_mailbox_t mailbox;
+static long per_producer;
+static message_t* messages;
+static atomic_int tokens;           //schedulings handed to the worker and not yet run
+static atomic_int producers_left = PRODUCERS;
+
+static void* producer(void* arg) 
+{
+    int id = (int) (intptr_t) arg;
+    for (long seq = 1; seq <= per_producer; seq++) 
+    {
+        message_t* message = &messages[id * per_producer + seq - 1];
+        message->producer = id;
+        message->seq = seq;
+        if (fifoMailboxPush(&mailbox, &message->link)) atomic_fetch_add(&tokens, 1);
+    }
+    atomic_fetch_sub(&producers_left, 1);
+    return NULL;
+}
+
+int main(void) 
+{
+    per_producer = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    messages = (message_t*) calloc((size_t) (PRODUCERS * per_producer), sizeof(message_t));
+    CHECK(messages != NULL);
+    fifoMailboxInit(&mailbox);
+    CHECK(fifoMailboxEmpty(&mailbox));
+
+    pthread_t ids[PRODUCERS];
+    for (intptr_t i = 0; i < PRODUCERS; i++) CHECK(pthread_create(&ids[i], NULL, producer, (void*) i) == 0);
+
+    long last[PRODUCERS] = { 0 };
+    long received = 0;
+    while (received < PRODUCERS * per_producer) 
+    {
+        if (atomic_load(&tokens) == 0) 
+        {
+            bool done = atomic_load(&producers_left) == 0;
+            CHECK(!done || atomic_load(&tokens) > 0); //messages left with nobody scheduled to run them
+            sched_yield();
+            continue;
+        }
+        CHECK(atomic_fetch_sub(&tokens, 1) == 1); //scheduled at most once at a time
+
+        for (int i = 0; i < BATCH; i++) 
+        {
+            fifo_mailbox_node_t* node = fifoMailboxPop(&mailbox);
+            if (node == NULL) break;
+            message_t* message = fifoMailboxEntry(node, message_t, link);
+            CHECK(message->seq == last[message->producer] + 1);
+            last[message->producer] = message->seq;
+            received++;
+        }
+        if (fifoMailboxRelease(&mailbox)) atomic_fetch_add(&tokens, 1);
+    }
+    for (int i = 0; i < PRODUCERS; i++) pthread_join(ids[i], NULL);
+
+    CHECK(fifoMailboxEmpty(&mailbox) && fifoMailboxPop(&mailbox) == NULL);
+    for (int i = 0; i < PRODUCERS; i++) CHECK(last[i] == per_producer);
+    free(messages);
+    printf("test_mailbox: ok\n");
+    return 0;
+}
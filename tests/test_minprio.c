@@ -0,0 +1,144 @@
+/**
+ * Description: fifoPullMinPriority: only items of negative priority or at least the
+ *  threshold are taken, staged lazy items included; a blocked caller is woken by a qualifying
+ *  push and by no other; unsupported buffers report ENOTSUP. Then fast-lane and ordinary
+ *  consumers share a buffer under load: every item arrives exactly once and the fast lane
+ *  never gets an item below its threshold.
+ **/
+#include "test_common.h"
+#include "../fifo.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define THRESHOLD 8
+#define PRODUCERS 2
+#define FAST 2
+#define ORDINARY 2
+#define POISON ((void*) -1)
+
+static fifo_buffer_t* buffer;
+static long per_producer;
+static atomic_long received;
+static atomic_uchar* seen;         //producers x per_producer delivery counts
+static atomic_bool returned;
+
+static void* waitUrgent(void* arg) 
+{
+    (void) arg;
+    void* data = fifoPullMinPriority(buffer, THRESHOLD, true);
+    atomic_store(&returned, true);
+    return data;
+}
+
+static void checkSequential(void) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.lazy_threshold = 4; //the threshold test must see staged items too
+    buffer = fifoBufferInitAttr(64, NULL, &attr);
+    CHECK(buffer != NULL);
+
+    CHECK(fifoPush(buffer, (void*) 1, 1, false) == 0);
+    CHECK(fifoPullMinPriority(buffer, THRESHOLD, false) == NULL);
+    CHECK(fifoPush(buffer, (void*) 2, THRESHOLD, false) == 0);
+    CHECK(fifoPush(buffer, (void*) 3, -1, false) == 0);
+    CHECK(fifoPullMinPriority(buffer, THRESHOLD, false) == (void*) 3);
+    CHECK(fifoPullMinPriority(buffer, THRESHOLD, false) == (void*) 2);
+    CHECK(fifoPullMinPriority(buffer, THRESHOLD, false) == NULL);
+
+    //Low-priority pushes must not release the blocked caller
+    atomic_store(&returned, false);
+    pthread_t id;
+    CHECK(pthread_create(&id, NULL, waitUrgent, NULL) == 0);
+    usleep(20000);
+    for (intptr_t i = 4; i < 10; i++) CHECK(fifoPush(buffer, (void*) i, THRESHOLD - 1, false) == 0);
+    usleep(20000);
+    CHECK(!atomic_load(&returned));
+    CHECK(fifoPush(buffer, (void*) 10, THRESHOLD + 1, false) == 0);
+    void* data;
+    pthread_join(id, &data);
+    CHECK(data == (void*) 10);
+
+    for (intptr_t i = 4; i < 10; i++) CHECK(fifoPull(buffer, false) == (void*) i);
+    CHECK(fifoPull(buffer, false) == (void*) 1);
+    free(fifoBufferClose(buffer));
+}
+
+static void checkUnsupported(void) 
+{
+    fifo_attr_t attrs[4];
+    for (int i = 0; i < 4; i++) fifoAttrInit(&attrs[i]);
+    attrs[0].backend = FIFO_BACKEND_FAA;
+    attrs[1].pull_order = FIFO_ORDER_LIFO;
+    attrs[2].signal_ring = 8;
+    attrs[3].realtime = true;
+    for (int i = 0; i < 4; i++) 
+    {
+        fifo_buffer_t* b = fifoBufferInitAttr(8, NULL, &attrs[i]);
+        CHECK(b != NULL);
+        CHECK(fifoPush(b, (void*) 1, THRESHOLD, false) == 0);
+        errno = 0;
+        CHECK(fifoPullMinPriority(b, THRESHOLD, false) == NULL && errno == ENOTSUP);
+        free(fifoBufferClose(b));
+    }
+}
+
+static void* producer(void* arg) 
+{
+    uintptr_t id = (uintptr_t) arg;
+    unsigned rng = 7 + (unsigned) id;
+    for (long seq = 1; seq <= per_producer; seq++) 
+    {
+        rng = rng * 1103515245 + 12345;
+        int priority = (int) ((rng >> 16) % (2 * THRESHOLD)) - 1;
+        uintptr_t item = ((uintptr_t) (priority + 1) << 32) | (id << 24) | (uintptr_t) seq; //priority travels with the item
+        CHECK(fifoPush(buffer, (void*) item, priority, true) == 0);
+    }
+    return NULL;
+}
+
+static void* consumer(void* arg) 
+{
+    bool fast = arg != NULL;
+    for (;;) 
+    {
+        void* data = fast ? fifoPullMinPriority(buffer, THRESHOLD, true) : fifoPull(buffer, true);
+        CHECK(data != NULL);
+        if (data == POISON) return NULL;
+        int priority = (int) ((uintptr_t) data >> 32) - 1;
+        if (fast) CHECK(priority < 0 || priority >= THRESHOLD);
+        long index = (long) (((uintptr_t) data >> 24) & 0xff) * per_producer + (long) ((uintptr_t) data & 0xffffff) - 1;
+        CHECK(atomic_fetch_add(&seen[index], 1) == 0);
+        atomic_fetch_add(&received, 1);
+    }
+}
+
+int main(void) 
+{
+    checkSequential();
+    checkUnsupported();
+
+    per_producer = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    buffer = fifoBufferInit(64, "minprio");
+    CHECK(buffer != NULL);
+    atomic_init(&received, 0);
+    seen = (atomic_uchar*) calloc((size_t) (PRODUCERS * per_producer), sizeof(atomic_uchar));
+    CHECK(seen != NULL && per_producer < (1 << 24));
+    pthread_t ids[PRODUCERS + FAST + ORDINARY];
+    for (uintptr_t i = 0; i < PRODUCERS; i++) CHECK(pthread_create(&ids[i], NULL, producer, (void*) i) == 0);
+    for (int i = 0; i < FAST + ORDINARY; i++) CHECK(pthread_create(&ids[PRODUCERS + i], NULL, consumer, i < FAST ? (void*) 1 : NULL) == 0);
+
+    for (int i = 0; i < PRODUCERS; i++) pthread_join(ids[i], NULL);
+    while (atomic_load(&received) < PRODUCERS * per_producer) usleep(1000);
+    for (int i = 0; i < FAST + ORDINARY; i++) CHECK(fifoPush(buffer, POISON, THRESHOLD, true) == 0); //qualifies for every consumer
+    for (int i = PRODUCERS; i < PRODUCERS + FAST + ORDINARY; i++) pthread_join(ids[i], NULL);
+    CHECK(atomic_load(&received) == PRODUCERS * per_producer);
+    CHECK(fifoPull(buffer, false) == NULL);
+
+    free(seen);
+    free(fifoBufferClose(buffer));
+    printf("test_minprio: ok\n");
+    return 0;
+}
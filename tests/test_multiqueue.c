@@ -0,0 +1,93 @@
+/**
+ * Description: FIFO_BACKEND_MULTIQUEUE: flush order against the list backend, sampled rank
+ *  error within the c x P heaps bound, and exactly-once delivery under concurrent producers
+ *  and consumers with a small capacity, so producers block, with consumers both polling and
+ *  parked. Pull order is relaxed, so it is only checked through the rank error.
+ **/
+#include "test_stress.h"
+
+//Pushes a fixed mix of priorities and returns the flushed data as a number, one digit per item
+static long flushOrder(fifo_backend_t backend) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = backend;
+    fifo_buffer_t* buffer = fifoBufferInitAttr(64, NULL, &attr);
+    CHECK(buffer != NULL);
+    int priorities[] = { -1, 5, 0, -1, 3, 2, -1 }; //no positive ties: those are ordered within one heap only
+    for (intptr_t i = 0; i < 7; i++) CHECK(fifoPush(buffer, (void*) (i + 1), priorities[i], false) == 0);
+
+    void** out = fifoFlush(buffer, true);
+    CHECK(out != NULL);
+    long order = 0;
+    for (int i = 0; out[i] != NULL; i++) order = order * 10 + (long) (intptr_t) out[i];
+    free(out);
+    free(fifoBufferClose(buffer));
+    return order;
+}
+
+//Pulls a shuffled set of distinct priorities. Every sampled pull may only be beaten by the
+//tops of other heaps, and two-choice pulls keep the mean well below that
+static void checkRankError(void) 
+{
+    const int threads = 4, items = 64 * FIFO_MQ_RANK_SAMPLE;
+    const int heaps = FIFO_MQ_FACTOR * threads;
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = FIFO_BACKEND_MULTIQUEUE;
+    attr.mq_threads = threads;
+    fifo_buffer_t* buffer = fifoBufferInitAttr(items, NULL, &attr);
+    CHECK(buffer != NULL);
+
+    unsigned rng = 4242;
+    int priorities[items];
+    for (int i = 0; i < items; i++) priorities[i] = i;
+    for (int i = items - 1; i > 0; i--) 
+    {
+        rng = rng * 1103515245 + 12345;
+        int j = (int) ((rng >> 16) % (unsigned) (i + 1));
+        int t = priorities[i];
+        priorities[i] = priorities[j];
+        priorities[j] = t;
+    }
+    for (int i = 0; i < items; i++) CHECK(fifoPush(buffer, (void*) (intptr_t) (priorities[i] + 1), priorities[i], false) == 0);
+
+    long displaced = 0;
+    for (int i = 0; i < items; i++) 
+    {
+        intptr_t data = (intptr_t) fifoPull(buffer, false);
+        CHECK(data >= 1 && data <= items);
+        displaced += labs((long) (items - data) - i); //distance from its exact pull position
+    }
+    CHECK(fifoPull(buffer, false) == NULL);
+
+    fifo_stats_t stats;
+    CHECK(fifoGetStats(buffer, &stats) == 0);
+    CHECK(stats.rank_error_samples >= (unsigned long) (items / FIFO_MQ_RANK_SAMPLE));
+    CHECK(stats.rank_error_max < (unsigned long) heaps);
+    CHECK(stats.rank_error_sum < stats.rank_error_samples * (unsigned long) heaps / 2);
+    CHECK(displaced / items < 4 * heaps);
+    free(fifoBufferClose(buffer));
+}
+
+int main(void) 
+{
+    long per_producer = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    CHECK(flushOrder(FIFO_BACKEND_MULTIQUEUE) == flushOrder(FIFO_BACKEND_LIST));
+    checkRankError();
+
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = FIFO_BACKEND_MULTIQUEUE;
+    attr.mq_threads = 4;
+    fifo_buffer_t* buffer = fifoBufferInitAttr(256, "multiqueue", &attr);
+    CHECK(buffer != NULL);
+
+    testStress(buffer, 1, 1, per_producer, false);
+    testStress(buffer, 4, 4, per_producer, false);
+    testStressBlocking(buffer, 4, 4, per_producer, false);
+
+    free(fifoBufferClose(buffer));
+    printf("test_multiqueue: ok\n");
+    return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * Description: Partitioned FIFO under load while consumers keep leaving and rejoining, so
+ *  partitions change owner with items in flight. Every item must arrive exactly once, items
+ *  of one key in push order and never two at once, and blocked consumers must not miss a
+ *  wake-up: a lost one leaves items queued with nobody to take them, caught by the alarm.
+ **/
+#include "test_common.h"
+#include "../fifo_partition.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#define KEYS 64
+#define PRODUCERS 2
+#define CONSUMERS 4
+#define CHURN 997               //items between a consumer's leave and rejoin
+#define POISON ((uintptr_t) -1)
+
+static fifo_partitioned_t* part;
+static long per_key;
+static atomic_long received;
+static atomic_bool holder[KEYS];    //item of this key being processed
+static long last[KEYS];             //last seq seen per key, guarded by holder
+
+static void* producer(void* arg) 
+{
+    uintptr_t id = (uintptr_t) arg;
+    for (long seq = 1; seq <= per_key; seq++) 
+    {
+        for (uintptr_t key = id; key < KEYS; key += PRODUCERS) CHECK(fifoPartitionedPush(part, key, (void*) ((key << 32) | (uintptr_t) seq), true) == 0);
+    }
+    return NULL;
+}
+
+static void* consumer(void* arg) 
+{
+    (void) arg;
+    int id = fifoPartitionedJoin(part);
+    CHECK(id >= 0);
+    int held = -1;
+    for (long handled = 1;; handled++) 
+    {
+        if (held >= 0) atomic_store(&holder[held], false);
+        held = -1;
+        if (handled % CHURN == 0) 
+        {
+            fifoPartitionedLeave(part, id);
+            id = fifoPartitionedJoin(part);
+            CHECK(id >= 0);
+        }
+
+        uintptr_t item = (uintptr_t) fifoPartitionedPull(part, id, true, NULL);
+        CHECK(item != 0);
+        if (item == POISON) break;
+        int key = (int) (item >> 32);
+        long seq = (long) (item & 0xffffffffu);
+        CHECK(key < KEYS && !atomic_exchange(&holder[key], true));
+        held = key;
+        CHECK(seq == last[key] + 1);
+        last[key] = seq;
+        atomic_fetch_add(&received, 1);
+    }
+    fifoPartitionedLeave(part, id);
+    return NULL;
+}
+
+int main(void) 
+{
+    per_key = testEnvLong("FIFO_TEST_ITEMS", 100000) / KEYS * PRODUCERS;
+    alarm(120);
+    part = fifoPartitionedInit(16, 64, CONSUMERS);
+    CHECK(part != NULL);
+
+    pthread_t consumers[CONSUMERS], producers[PRODUCERS];
+    for (int i = 0; i < CONSUMERS; i++) CHECK(pthread_create(&consumers[i], NULL, consumer, NULL) == 0);
+    for (uintptr_t i = 0; i < PRODUCERS; i++) CHECK(pthread_create(&producers[i], NULL, producer, (void*) i) == 0);
+    for (int i = 0; i < PRODUCERS; i++) pthread_join(producers[i], NULL);
+
+    while (atomic_load(&received) < KEYS * per_key) usleep(1000);
+    for (uint64_t i = 0; i < CONSUMERS; i++) CHECK(fifoPartitionedPush(part, i, (void*) POISON, true) == 0);
+    for (int i = 0; i < CONSUMERS; i++) pthread_join(consumers[i], NULL);
+    for (int key = 0; key < KEYS; key++) CHECK(last[key] == per_key);
+
+    void** rest = fifoPartitionedClose(part);
+    CHECK(rest != NULL && rest[0] == NULL);
+    free(rest);
+    printf("test_partition: ok\n");
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * Description: FIFO_BACKEND_RADIX: keys are pulled smallest first and equal keys in push
+ *  order, snapshots report exact pull order without disturbing it, keys below the last one
+ *  pulled are refused, and blocked producers and consumers are woken under load.
+ **/
+#include "test_common.h"
+#include "../fifo.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define PRODUCERS 2
+#define SHIFT 20                //item = (key << SHIFT) | push index, so equal keys stay distinct
+
+static fifo_buffer_t* buffer;
+static long per_producer;
+static atomic_long next_key;
+
+static fifo_buffer_t* radixBuffer(int capacity) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = FIFO_BACKEND_RADIX;
+    fifo_buffer_t* b = fifoBufferInitAttr(capacity, NULL, &attr);
+    CHECK(b != NULL);
+    return b;
+}
+
+//Keys repeat and arrive out of order; pulls and snapshots must agree on one order
+static void testOrder(void) 
+{
+    static const uint64_t keys[] = { 40, 7, 7, 1000000, 3, 40, 0, 7, 65536, 3 };
+    const int count = sizeof(keys) / sizeof(keys[0]);
+    fifo_buffer_t* b = radixBuffer(count);
+    for (int i = 0; i < count; i++) CHECK(fifoPushKey(b, (void*) ((keys[i] << SHIFT) | (uintptr_t) (i + 1)), keys[i], false) == 0);
+    CHECK(fifoPushKey(b, (void*) 1, 1, false) == -1); //full
+
+    fifo_snapshot_t snap;
+    fifo_snapshot_entry_t entries[count];
+    CHECK(fifoSnapshot(b, &snap, entries, 4, true) == 0);
+    CHECK(snap.count == 4 && snap.occupancy == count);
+    uintptr_t expected[4] = { (0 << SHIFT) | 7, (3 << SHIFT) | 5, (3 << SHIFT) | 10, (7 << SHIFT) | 2 };
+    for (int i = 0; i < 4; i++) CHECK((uintptr_t) entries[i].data == expected[i] && entries[i].position == i);
+    CHECK(fifoSnapshot(b, &snap, entries, count, true) == 0);
+    CHECK(snap.count == count && entries[count - 1].priority == 1000000);
+
+    for (int i = 0; i < count; i++) 
+    {
+        uintptr_t item = (uintptr_t) fifoPull(b, false);
+        CHECK(item == (uintptr_t) entries[i].data); //the snapshot changed nothing
+    }
+    CHECK(fifoPull(b, false) == NULL);
+
+    //1000000 was pulled last: smaller keys are refused, equal ones queue behind the at-last slot
+    CHECK(fifoPushKey(b, (void*) 1, 999999, false) == EINVAL);
+    CHECK(fifoPushKey(b, (void*) 2, 1000000, false) == 0);
+    CHECK(fifoPush(b, (void*) 3, -1, false) == 0);
+    CHECK(fifoPushKey(b, (void*) 4, 1000001, false) == 0);
+    for (uintptr_t i = 2; i <= 4; i++) CHECK((uintptr_t) fifoPull(b, false) == i);
+    free(fifoBufferClose(b));
+}
+
+//Keys come from a shared counter, so a producer can lose the race against a pull of a
+//larger key; it then queues at the last key instead
+static void* producer(void* arg) 
+{
+    (void) arg;
+    for (long i = 0; i < per_producer; i++) 
+    {
+        uint64_t key = (uint64_t) atomic_fetch_add(&next_key, 1);
+        int status = fifoPushKey(buffer, (void*) ((key << SHIFT) | 1), key, true);
+        if (status == EINVAL) status = fifoPush(buffer, (void*) 1, -1, true); //key 0 marks at-last items
+        CHECK(status == 0);
+    }
+    return NULL;
+}
+
+int main(void) 
+{
+    testOrder();
+
+    per_producer = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    buffer = radixBuffer(8); //small, so producers block as well as the consumer
+    atomic_init(&next_key, 1);
+    pthread_t ids[PRODUCERS];
+    for (int i = 0; i < PRODUCERS; i++) CHECK(pthread_create(&ids[i], NULL, producer, NULL) == 0);
+
+    char* seen = (char*) calloc((size_t) (PRODUCERS * per_producer + 1), 1);
+    CHECK(seen != NULL);
+    uint64_t last = 0;
+    for (long i = 0; i < PRODUCERS * per_producer; i++) 
+    {
+        uintptr_t item = (uintptr_t) fifoPull(buffer, true);
+        uint64_t key = item >> SHIFT;
+        if (key == 0) continue;
+        CHECK(key >= last && key <= (uint64_t) (PRODUCERS * per_producer) && !seen[key]);
+        seen[key] = 1;
+        last = key;
+    }
+    for (int i = 0; i < PRODUCERS; i++) pthread_join(ids[i], NULL);
+    CHECK(fifoPull(buffer, false) == NULL);
+
+    free(seen);
+    free(fifoBufferClose(buffer));
+    printf("test_radix: ok\n");
+    return 0;
+}
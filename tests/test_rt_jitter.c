@@ -0,0 +1,97 @@
+/**
+ * Description: Latency jitter of a real-time buffer (attr.realtime). A SCHED_FIFO thread
+ *  times push+pull pairs while ordinary threads hammer the same buffer, so it regularly finds
+ *  the FIFO_LOCK_PI lock held by a lower-priority thread. The worst case is checked against
+ *  FIFO_JITTER_MAX_US (default 1000). Without permission for SCHED_FIFO the numbers are
+ *  reported but not checked, since an ordinary thread can be preempted for any length of time.
+ **/
+#define _GNU_SOURCE
+#include "test_common.h"
+#include "../fifo.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <sys/mman.h>
+
+#define BUFFER_SIZE 1024
+#define BACKGROUND_THREADS 2
+
+static fifo_buffer_t* buffer;
+static atomic_bool stop;
+static long iterations;
+static uint64_t* samples;
+
+static void* background(void* arg) 
+{
+    intptr_t item = (intptr_t) arg;
+    while (!atomic_load(&stop)) 
+    {
+        fifoPush(buffer, (void*) item, (int) (item & 7), false);
+        fifoPull(buffer, false);
+    }
+    return NULL;
+}
+
+static void* realtime(void* arg) 
+{
+    (void) arg;
+    struct timespec gap = { 0, 20000 }; //lets the background threads in on a single CPU
+    for (long i = 0; i < iterations; i++) 
+    {
+        uint64_t start = testNowNs();
+        fifoPush(buffer, (void*) (intptr_t) (i + 1), 3, true);
+        fifoPull(buffer, true);
+        samples[i] = testNowNs() - start;
+        nanosleep(&gap, NULL);
+    }
+    return NULL;
+}
+
+static int compareSamples(const void* a, const void* b) 
+{
+    uint64_t x = *(const uint64_t*) a, y = *(const uint64_t*) b;
+    return x < y ? -1 : x > y;
+}
+
+int main(void) 
+{
+    iterations = testEnvLong("FIFO_JITTER_ITERATIONS", 20000);
+    long max_us = testEnvLong("FIFO_JITTER_MAX_US", 1000);
+    samples = (uint64_t*) calloc((size_t) iterations, sizeof(uint64_t));
+    CHECK(samples != NULL);
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) perror("mlockall");
+
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.realtime = true;
+    buffer = fifoBufferInitAttr(BUFFER_SIZE, "jitter", &attr);
+    CHECK(buffer != NULL);
+
+    pthread_t others[BACKGROUND_THREADS];
+    for (intptr_t i = 0; i < BACKGROUND_THREADS; i++) CHECK(pthread_create(&others[i], NULL, background, (void*) (i + 1)) == 0);
+
+    pthread_attr_t rt_attr;
+    struct sched_param param = { .sched_priority = sched_get_priority_min(SCHED_FIFO) + 10 };
+    pthread_attr_init(&rt_attr);
+    pthread_attr_setinheritsched(&rt_attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&rt_attr, SCHED_FIFO);
+    pthread_attr_setschedparam(&rt_attr, &param);
+    pthread_t rt;
+    bool enforced = pthread_create(&rt, &rt_attr, realtime, NULL) == 0;
+    if (!enforced) CHECK(pthread_create(&rt, NULL, realtime, NULL) == 0);
+    pthread_attr_destroy(&rt_attr);
+
+    pthread_join(rt, NULL);
+    atomic_store(&stop, true);
+    for (int i = 0; i < BACKGROUND_THREADS; i++) pthread_join(others[i], NULL);
+    free(fifoBufferClose(buffer));
+
+    qsort(samples, (size_t) iterations, sizeof(uint64_t), compareSamples);
+    uint64_t p50 = samples[iterations / 2], p99 = samples[iterations * 99 / 100], worst = samples[iterations - 1];
+    printf("test_rt_jitter: %ld push+pull pairs, p50 %lu ns, p99 %lu ns, max %lu ns%s\n", iterations, 
+        (unsigned long) p50, (unsigned long) p99, (unsigned long) worst, enforced ? "" : " (no SCHED_FIFO, bound not checked)");
+    if (enforced) CHECK(worst <= (uint64_t) max_us * 1000);
+    free(samples);
+    return 0;
+}
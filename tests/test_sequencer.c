@@ -0,0 +1,106 @@
+/**
+ * Description: Sequencer: results completed out of order are received strictly in ticket
+ *  order, a full window stops further pulls until the consumer releases a result, and under
+ *  load with workers finishing in random order every result arrives once, in source order.
+ **/
+#include "test_common.h"
+#include "../fifo_sequencer.h"
+#include <pthread.h>
+#include <sched.h>
+
+#define WORKERS 4
+#define WINDOW 8
+#define POISON ((void*) -1)
+
+static fifo_buffer_t* source;
+static fifo_sequencer_t* sequencer;
+static long items;
+
+static void checkWindow(void) 
+{
+    source = fifoBufferInit(16, NULL);
+    sequencer = fifoSequencerCreate(source, 2);
+    CHECK(source != NULL && sequencer != NULL);
+
+    uint64_t ticket[3];
+    void* result;
+    CHECK(fifoSequencerPull(sequencer, &ticket[0], false) == NULL); //empty source
+    CHECK(!fifoSequencerNext(sequencer, &result, false));
+    for (intptr_t i = 1; i <= 3; i++) CHECK(fifoPush(source, (void*) i, 0, false) == 0);
+
+    CHECK(fifoSequencerPull(sequencer, &ticket[0], false) == (void*) 1);
+    CHECK(fifoSequencerPull(sequencer, &ticket[1], false) == (void*) 2);
+    CHECK(ticket[1] == ticket[0] + 1);
+    CHECK(fifoSequencerPull(sequencer, &ticket[2], false) == NULL); //window full, item 3 stays queued
+
+    fifoSequencerComplete(sequencer, ticket[1], (void*) 20);
+    CHECK(!fifoSequencerNext(sequencer, &result, false)); //ticket 0 holds it back
+    fifoSequencerComplete(sequencer, ticket[0], NULL);
+    CHECK(fifoSequencerNext(sequencer, &result, false) && result == NULL);
+
+    CHECK(fifoSequencerPull(sequencer, &ticket[2], false) == (void*) 3);
+    fifoSequencerComplete(sequencer, ticket[2], (void*) 30);
+    CHECK(fifoSequencerNext(sequencer, &result, true) && result == (void*) 20);
+    CHECK(fifoSequencerNext(sequencer, &result, true) && result == (void*) 30);
+    CHECK(!fifoSequencerNext(sequencer, &result, false));
+
+    fifoSequencerDestroy(sequencer);
+    free(fifoBufferClose(source));
+}
+
+static void* producer(void* arg) 
+{
+    (void) arg;
+    for (intptr_t i = 1; i <= items; i++) CHECK(fifoPush(source, (void*) i, 0, true) == 0);
+    for (int i = 0; i < WORKERS; i++) CHECK(fifoPush(source, POISON, 0, true) == 0);
+    return NULL;
+}
+
+static void* worker(void* arg) 
+{
+    unsigned rng = 17 + (unsigned) (uintptr_t) arg;
+    for (;;) 
+    {
+        uint64_t ticket;
+        void* item = fifoSequencerPull(sequencer, &ticket, true);
+        CHECK(item != NULL);
+        rng = rng * 1103515245 + 12345;
+        for (unsigned spin = (rng >> 16) % 4; spin > 0; spin--) sched_yield(); //finish out of order
+        if (item == POISON) 
+        {
+            fifoSequencerComplete(sequencer, ticket, POISON);
+            return NULL;
+        }
+        fifoSequencerComplete(sequencer, ticket, (void*) ((intptr_t) item * 2));
+    }
+}
+
+int main(void) 
+{
+    checkWindow();
+
+    items = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    source = fifoBufferInit(64, "sequencer");
+    sequencer = fifoSequencerCreate(source, WINDOW);
+    CHECK(source != NULL && sequencer != NULL);
+
+    pthread_t ids[WORKERS + 1];
+    CHECK(pthread_create(&ids[WORKERS], NULL, producer, NULL) == 0);
+    for (uintptr_t i = 0; i < WORKERS; i++) CHECK(pthread_create(&ids[i], NULL, worker, (void*) i) == 0);
+
+    void* result;
+    for (intptr_t i = 1; i <= items; i++) 
+    {
+        CHECK(fifoSequencerNext(sequencer, &result, true));
+        CHECK(result == (void*) (2 * i));
+    }
+    for (int i = 0; i < WORKERS; i++) CHECK(fifoSequencerNext(sequencer, &result, true) && result == POISON);
+    for (int i = 0; i <= WORKERS; i++) pthread_join(ids[i], NULL);
+    CHECK(!fifoSequencerNext(sequencer, &result, false));
+    CHECK(fifoPull(source, false) == NULL);
+
+    fifoSequencerDestroy(sequencer);
+    free(fifoBufferClose(source));
+    printf("test_sequencer: ok\n");
+    return 0;
+}
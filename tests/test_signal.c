@@ -0,0 +1,92 @@
+/**
+ * Description: fifoPushSignalSafe from a SIGALRM handler, racing fifoPush from producer
+ *  threads and a consumer in blocking fifoPull. The handler may interrupt any of them, on the
+ *  same buffer, mid-operation. Every item must arrive exactly once and each source's items in
+ *  push order, and the consumer must be woken by signal-safe pushes alone.
+ **/
+#include "test_common.h"
+#include "../fifo.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <sys/time.h>
+
+#define PRODUCERS 2
+#define SOURCES (PRODUCERS + 1) //the signal handler is the last source
+
+static fifo_buffer_t* buffer;
+static long per_producer;
+static long signal_items;
+static atomic_long signal_pushed;
+static atomic_flag in_handler = ATOMIC_FLAG_INIT;
+
+//SIGALRM goes to any thread, so two handlers may run at once; only one pushes, keeping the
+//signal source a single ordered producer
+static void onAlarm(int signo) 
+{
+    (void) signo;
+    if (atomic_flag_test_and_set(&in_handler)) return;
+    long seq = atomic_load(&signal_pushed);
+    if (seq < signal_items && fifoPushSignalSafe(buffer, (void*) (((uintptr_t) PRODUCERS << 32) | (uintptr_t) (seq + 1)), 0) == 0) 
+    {
+        atomic_store(&signal_pushed, seq + 1);
+    } //ring full: retry on the next tick
+    atomic_flag_clear(&in_handler);
+}
+
+static void* producer(void* arg) 
+{
+    uintptr_t id = (uintptr_t) arg;
+    for (long seq = 1; seq <= per_producer; seq++) CHECK(fifoPush(buffer, (void*) ((id << 32) | (uintptr_t) seq), 0, true) == 0);
+    return NULL;
+}
+
+int main(void) 
+{
+    per_producer = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    signal_items = testEnvLong("FIFO_TEST_SIGNAL_ITEMS", 2000);
+
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.signal_ring = 64;
+    buffer = fifoBufferInitAttr(256, "signal", &attr);
+    CHECK(buffer != NULL);
+
+    struct sigaction action = { .sa_handler = onAlarm, .sa_flags = SA_RESTART };
+    sigemptyset(&action.sa_mask);
+    CHECK(sigaction(SIGALRM, &action, NULL) == 0);
+    struct itimerval timer = { { 0, 100 }, { 0, 100 } };
+    CHECK(setitimer(ITIMER_REAL, &timer, NULL) == 0);
+
+    pthread_t ids[PRODUCERS];
+    for (uintptr_t i = 0; i < PRODUCERS; i++) CHECK(pthread_create(&ids[i], NULL, producer, (void*) i) == 0);
+
+    long total = PRODUCERS * per_producer + signal_items;
+    long last[SOURCES] = { 0 };
+    long received[SOURCES] = { 0 };
+    for (long n = 0; n < total; n++) 
+    {
+        uintptr_t item = (uintptr_t) fifoPull(buffer, true);
+        CHECK(item != 0);
+        int source = (int) (item >> 32);
+        long seq = (long) (item & 0xffffffffu);
+        CHECK(source < SOURCES && seq > last[source]); //in order, hence also at most once
+        last[source] = seq;
+        received[source]++;
+    }
+    for (int i = 0; i < PRODUCERS; i++) pthread_join(ids[i], NULL);
+
+    struct itimerval off = { { 0, 0 }, { 0, 0 } };
+    setitimer(ITIMER_REAL, &off, NULL);
+    for (int i = 0; i < PRODUCERS; i++) CHECK(received[i] == per_producer && last[i] == per_producer);
+    CHECK(received[PRODUCERS] == signal_items && last[PRODUCERS] == signal_items);
+    CHECK(fifoPull(buffer, false) == NULL);
+
+    fifo_stats_t stats;
+    CHECK(fifoGetStats(buffer, &stats) == 0);
+    CHECK(stats.pushes == stats.pulls);
+
+    free(fifoBufferClose(buffer));
+    printf("test_signal: ok\n");
+    return 0;
+}
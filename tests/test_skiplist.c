@@ -0,0 +1,118 @@
+/**
+ * Description: FIFO_BACKEND_SKIPLIST: single-threaded pull order against the list backend for
+ *  random priorities, negatives and ties included; exact priority order seen by each of
+ *  several threads pulling from a list filled by concurrent inserts; then exactly-once
+ *  delivery and per-producer order under concurrent producers and consumers, polling and
+ *  parked, with enough pulls to trigger batch unlinks.
+ **/
+#include "test_stress.h"
+#include <string.h>
+
+#define ORDER_ITEMS 5000
+#define THREADS 4
+#define PRIORITY_SHIFT 40       //item = (priority << PRIORITY_SHIFT) | (thread << 32) | seq
+
+static fifo_buffer_t* ordered;
+static atomic_long pulled;
+
+static void checkOrderMatchesList(void) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    fifo_buffer_t* list = fifoBufferInitAttr(ORDER_ITEMS, NULL, &attr);
+    attr.backend = FIFO_BACKEND_SKIPLIST;
+    fifo_buffer_t* skip = fifoBufferInitAttr(ORDER_ITEMS, NULL, &attr);
+    CHECK(list != NULL && skip != NULL);
+
+    unsigned rng = 12345;
+    for (intptr_t i = 1; i <= ORDER_ITEMS; i++) 
+    {
+        rng = rng * 1103515245 + 12345;
+        int priority = (int) ((rng >> 16) % 20) - 3; //about one in seven negative, many ties
+        CHECK(fifoPush(list, (void*) i, priority, false) == 0);
+        CHECK(fifoPush(skip, (void*) i, priority, false) == 0);
+        if (i % 3 == 0) CHECK(fifoPull(list, false) == fifoPull(skip, false)); //interleave pulls
+    }
+    void* data;
+    while ((data = fifoPull(list, false)) != NULL) CHECK(fifoPull(skip, false) == data);
+    CHECK(fifoPull(skip, false) == NULL);
+
+    free(fifoBufferClose(list));
+    free(fifoBufferClose(skip));
+}
+
+static void* orderedProducer(void* arg) 
+{
+    uintptr_t id = (uintptr_t) arg;
+    unsigned rng = 99 + (unsigned) id;
+    for (uintptr_t seq = 1; seq <= ORDER_ITEMS; seq++) 
+    {
+        rng = rng * 1103515245 + 12345;
+        uintptr_t priority = (rng >> 16) % 50;
+        CHECK(fifoPush(ordered, (void*) ((priority << PRIORITY_SHIFT) | (id << 32) | seq), (int) priority, false) == 0);
+    }
+    return NULL;
+}
+
+//Pulls are linearizable, so one thread's pulls from a list nobody pushes to must come out
+//highest priority first, and equal priorities of one producer in push order
+static void* orderedConsumer(void* arg) 
+{
+    (void) arg;
+    uintptr_t last_priority = UINTPTR_MAX;
+    uintptr_t last_seq[THREADS] = { 0 };
+    uintptr_t item;
+    while ((item = (uintptr_t) fifoPull(ordered, false)) != 0) 
+    {
+        uintptr_t priority = item >> PRIORITY_SHIFT;
+        uintptr_t id = (item >> 32) & 0xff;
+        uintptr_t seq = item & 0xffffffffu;
+        CHECK(priority <= last_priority && id < THREADS);
+        if (priority < last_priority) memset(last_seq, 0, sizeof(last_seq));
+        CHECK(seq > last_seq[id]);
+        last_priority = priority;
+        last_seq[id] = seq;
+        atomic_fetch_add(&pulled, 1);
+    }
+    return NULL;
+}
+
+static void checkConcurrentOrder(void) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = FIFO_BACKEND_SKIPLIST;
+    ordered = fifoBufferInitAttr(THREADS * ORDER_ITEMS, NULL, &attr);
+    CHECK(ordered != NULL);
+    atomic_init(&pulled, 0);
+
+    pthread_t ids[THREADS];
+    for (uintptr_t i = 0; i < THREADS; i++) CHECK(pthread_create(&ids[i], NULL, orderedProducer, (void*) i) == 0);
+    for (int i = 0; i < THREADS; i++) pthread_join(ids[i], NULL);
+    for (int i = 0; i < THREADS; i++) CHECK(pthread_create(&ids[i], NULL, orderedConsumer, NULL) == 0);
+    for (int i = 0; i < THREADS; i++) pthread_join(ids[i], NULL);
+    CHECK(atomic_load(&pulled) == THREADS * ORDER_ITEMS);
+
+    free(fifoBufferClose(ordered));
+}
+
+int main(void) 
+{
+    long per_producer = testEnvLong("FIFO_TEST_ITEMS", 100000);
+    checkOrderMatchesList();
+    checkConcurrentOrder();
+
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.backend = FIFO_BACKEND_SKIPLIST;
+    fifo_buffer_t* buffer = fifoBufferInitAttr(1024, "skiplist", &attr);
+    CHECK(buffer != NULL);
+
+    testStress(buffer, 1, 1, per_producer, true);
+    testStress(buffer, 4, 4, per_producer, true);
+    testStressBlocking(buffer, 4, 4, per_producer, true);
+
+    free(fifoBufferClose(buffer));
+    printf("test_skiplist: ok\n");
+    return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * Description: Strand executor with several posting threads. Tasks of one strand must run one
+ *  at a time and in post order, every task exactly once, and fifoExecutorDestroy must return
+ *  only after the last one. Keyed posts are checked the same way per key.
+ **/
+#include "test_common.h"
+#include "../fifo_strand.h"
+#include <pthread.h>
+#include <errno.h>
+#include <stdatomic.h>
+
+#define WORKERS 4
+#define POSTERS 4
+#define STRANDS 32          //per poster, so each strand has one poster and a total order
+#define KEYED 16
+
+typedef struct Lane {
+    atomic_bool running;
+    long last;
+} lane_t;
+
+typedef struct Task {
+    lane_t* lane;
+    long seq;
+} task_t;
+
+static fifo_executor_t* executor;
+static fifo_strand_t strands[POSTERS * STRANDS];
+static lane_t lanes[POSTERS * STRANDS + POSTERS * KEYED];
+static long per_lane;
+static atomic_long ran;
+
+static void runTask(void* arg) 
+{
+    task_t* task = (task_t*) arg;
+    CHECK(!atomic_exchange(&task->lane->running, true));
+    CHECK(task->seq == task->lane->last + 1);
+    task->lane->last = task->seq;
+    atomic_store(&task->lane->running, false);
+    atomic_fetch_add(&ran, 1);
+    free(task);
+}
+
+static void* poster(void* arg) 
+{
+    int id = (int) (intptr_t) arg;
+    for (long seq = 1; seq <= per_lane; seq++) 
+    {
+        for (int s = 0; s < STRANDS; s++) 
+        {
+            task_t* task = (task_t*) malloc(sizeof(task_t));
+            CHECK(task != NULL);
+            task->lane = &lanes[id * STRANDS + s];
+            task->seq = seq;
+            CHECK(fifoStrandPost(&strands[id * STRANDS + s], runTask, task) == 0);
+        }
+        for (int k = 0; k < KEYED; k++) 
+        {
+            task_t* task = (task_t*) malloc(sizeof(task_t));
+            CHECK(task != NULL);
+            task->lane = &lanes[POSTERS * STRANDS + id * KEYED + k];
+            task->seq = seq;
+            CHECK(fifoExecutorPost(executor, (uint64_t) (id * KEYED + k), runTask, task) == 0);
+        }
+    }
+    return NULL;
+}
+
+int main(void) 
+{
+    per_lane = testEnvLong("FIFO_TEST_ITEMS", 100000) / (STRANDS + KEYED);
+    executor = fifoExecutorCreate(WORKERS, 8); //fewer keyed strands than keys: keys share strands
+    CHECK(executor != NULL);
+    for (int i = 0; i < POSTERS * STRANDS; i++) fifoStrandInit(&strands[i], executor);
+
+    pthread_t ids[POSTERS];
+    for (intptr_t i = 0; i < POSTERS; i++) CHECK(pthread_create(&ids[i], NULL, poster, (void*) i) == 0);
+    for (int i = 0; i < POSTERS; i++) pthread_join(ids[i], NULL);
+    fifoExecutorDestroy(executor);
+
+    CHECK(atomic_load(&ran) == POSTERS * (STRANDS + KEYED) * per_lane);
+    for (size_t i = 0; i < sizeof(lanes) / sizeof(lanes[0]); i++) CHECK(lanes[i].last == per_lane);
+
+    fifo_executor_t* unkeyed = fifoExecutorCreate(1, 0);
+    CHECK(unkeyed != NULL);
+    CHECK(fifoExecutorPost(unkeyed, 1, runTask, NULL) == EINVAL);
+    fifoExecutorDestroy(unkeyed);
+    printf("test_strand: ok\n");
+    return 0;
+}
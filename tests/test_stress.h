@@ -0,0 +1,124 @@
+/**
+ * Description: Multi-producer, multi-consumer stress harness shared by the backend tests.
+ *  Producer p pushes items (p << 32) | seq for seq = 1..per_producer with priority 0; consumers
+ *  pull without blocking until every item has arrived. Each item must arrive exactly once,
+ *  and with ordered set every consumer must see each producer's items in push order, which
+ *  any linearizable FIFO guarantees. testStressBatched has producers push with fifoPushBatch.
+ *  testStressBlocking has consumers park in blocking pulls instead; the consumer that takes
+ *  the last item wakes the others with one poison item each.
+ **/
+
+#ifndef _FIFO_TEST_STRESS_H_
+#define _FIFO_TEST_STRESS_H_
+
+    #include "test_common.h"
+    #include "../fifo.h"
+    #include <pthread.h>
+    #include <sched.h>
+    #include <stdatomic.h>
+    #include <stdbool.h>
+
+    typedef struct StressRun {
+        fifo_buffer_t* buffer;
+        int producers;
+        long per_producer;
+        bool ordered;
+        int batch;              //items per fifoPushBatch call, 1 for plain fifoPush
+        int consumers;
+        bool blocking;          //consumers pull blocking, see stressConsumer
+        atomic_long received;
+        atomic_uchar* seen;     //producers x per_producer delivery counts
+    } stress_run_t;
+
+    typedef struct StressThread {
+        stress_run_t* run;
+        int id;
+    } stress_thread_t;
+
+    static void* stressProducer(void* arg) 
+    {
+        stress_thread_t* self = (stress_thread_t*) arg;
+        void* items[self->run->batch];
+        for (long seq = 1; seq <= self->run->per_producer; ) 
+        {
+            int count = 0;
+            while (count < self->run->batch && seq <= self->run->per_producer) items[count++] = (void*) (((uintptr_t) self->id << 32) | (uintptr_t) seq++);
+            if (self->run->batch == 1) CHECK(fifoPush(self->run->buffer, items[0], 0, true) == 0);
+            else CHECK(fifoPushBatch(self->run->buffer, items, NULL, count, true) == 0);
+        }
+        return NULL;
+    }
+
+    static void* stressConsumer(void* arg) 
+    {
+        stress_run_t* run = ((stress_thread_t*) arg)->run;
+        long total = run->producers * run->per_producer;
+        long* last = (long*) calloc((size_t) run->producers, sizeof(long)); //last seq seen from each producer
+        CHECK(last != NULL);
+        uintptr_t poison = (uintptr_t) run->producers << 32; //no producer has this id
+        while (run->blocking || atomic_load(&run->received) < total) 
+        {
+            uintptr_t item = (uintptr_t) fifoPull(run->buffer, run->blocking);
+            if (item == poison) break;
+            if (item == 0) 
+            {
+                CHECK(!run->blocking);
+                sched_yield();
+                continue;
+            }
+            int producer = (int) (item >> 32);
+            long seq = (long) (item & 0xffffffffu);
+            CHECK(producer < run->producers && seq >= 1 && seq <= run->per_producer);
+            CHECK(atomic_fetch_add(&run->seen[producer * run->per_producer + seq - 1], 1) == 0);
+            if (run->ordered) CHECK(seq > last[producer]);
+            last[producer] = seq;
+            if (atomic_fetch_add(&run->received, 1) + 1 == total && run->blocking) 
+            {
+                for (int i = 1; i < run->consumers; i++) CHECK(fifoPush(run->buffer, (void*) poison, 0, true) == 0);
+                break;
+            } //only now: a poison pulled early would strand items in relaxed backends
+        }
+        free(last);
+        return NULL;
+    }
+
+    //Runs the stress test on buffer, which must be empty, and leaves it empty. batch must not
+    //exceed the buffer capacity
+    static void testStressRun(fifo_buffer_t* buffer, int producers, int consumers, long per_producer, bool ordered, int batch, bool blocking) 
+    {
+        stress_run_t run = { .buffer = buffer, .producers = producers, .per_producer = per_producer, .ordered = ordered, .batch = batch, .consumers = consumers, .blocking = blocking };
+        atomic_init(&run.received, 0);
+        run.seen = (atomic_uchar*) calloc((size_t) (producers * per_producer), sizeof(atomic_uchar));
+        CHECK(run.seen != NULL);
+
+        pthread_t ids[producers + consumers];
+        stress_thread_t threads[producers + consumers];
+        for (int i = 0; i < producers + consumers; i++) 
+        {
+            threads[i].run = &run;
+            threads[i].id = i < producers ? i : i - producers;
+            CHECK(pthread_create(&ids[i], NULL, i < producers ? stressProducer : stressConsumer, &threads[i]) == 0);
+        }
+        for (int i = 0; i < producers + consumers; i++) pthread_join(ids[i], NULL);
+
+        for (long i = 0; i < producers * per_producer; i++) CHECK(atomic_load(&run.seen[i]) == 1);
+        CHECK(fifoPull(buffer, false) == NULL);
+        free(run.seen);
+    }
+
+    static void testStressBatched(fifo_buffer_t* buffer, int producers, int consumers, long per_producer, bool ordered, int batch) 
+    {
+        testStressRun(buffer, producers, consumers, per_producer, ordered, batch, false);
+    }
+
+    static void testStress(fifo_buffer_t* buffer, int producers, int consumers, long per_producer, bool ordered) 
+    {
+        testStressRun(buffer, producers, consumers, per_producer, ordered, 1, false);
+    }
+
+    static void testStressBlocking(fifo_buffer_t* buffer, int producers, int consumers, long per_producer, bool ordered) 
+    {
+        testStressRun(buffer, producers, consumers, per_producer, ordered, 1, true);
+    }
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * Description: fifoPushUnique: with FIFO_DEDUP_EXACT a key is refused with EEXIST exactly
+ *  while an item with that key is queued, checked against a model under a long random mix of
+ *  pushes and pulls, and duplicates are folded in by dedup_merge; FIFO_DEDUP_FILTER never
+ *  lets a queued key through and forgets everything on flush; concurrent pushes of the same
+ *  keys queue each key once; buffers without a key index report ENOTSUP.
+ **/
+#include "test_common.h"
+#include "../fifo.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define CAPACITY 64
+#define KEYS 100                //key range of the model run, larger than the capacity
+#define STEPS 200000
+#define THREADS 4
+
+static fifo_buffer_t* buffer;
+static atomic_int accepted;
+
+static fifo_buffer_t* uniqueBuffer(fifo_dedup_mode_t mode, void* (*merge)(void*, void*)) 
+{
+    fifo_attr_t attr;
+    fifoAttrInit(&attr);
+    attr.dedup = mode;
+    attr.dedup_merge = merge;
+    fifo_buffer_t* b = fifoBufferInitAttr(CAPACITY, NULL, &attr);
+    CHECK(b != NULL);
+    return b;
+}
+
+static void* sum(void* queued, void* incoming) 
+{
+    return (void*) ((intptr_t) queued + (intptr_t) incoming);
+}
+
+//Priority 0 only, so the buffer is a plain queue and the model is a ring of keys
+static void checkExactAgainstModel(void) 
+{
+    fifo_buffer_t* b = uniqueBuffer(FIFO_DEDUP_EXACT, NULL);
+    uint64_t ring[CAPACITY];
+    int head = 0, count = 0;
+    bool queued[KEYS] = { false };
+
+    unsigned rng = 2024;
+    for (int step = 0; step < STEPS; step++) 
+    {
+        rng = rng * 1103515245 + 12345;
+        if ((rng >> 16) % 8 < 5) 
+        {
+            uint64_t key = (rng >> 8) % KEYS;
+            int status = fifoPushUnique(b, (void*) (intptr_t) (key + 1), 0, key, false);
+            if (queued[key]) CHECK(status == EEXIST); //also when full
+            else if (count == CAPACITY) CHECK(status == -1);
+            else 
+            {
+                CHECK(status == 0);
+                queued[key] = true;
+                ring[(head + count++) % CAPACITY] = key;
+            }
+        }
+        else if (count > 0) 
+        {
+            uint64_t key = ring[head];
+            CHECK(fifoPull(b, false) == (void*) (intptr_t) (key + 1));
+            queued[key] = false;
+            head = (head + 1) % CAPACITY;
+            count--;
+        }
+        else CHECK(fifoPull(b, false) == NULL);
+    }
+
+    void** out = fifoFlush(b, true);
+    CHECK(out != NULL);
+    free(out);
+    for (uint64_t key = 0; key < CAPACITY; key++) CHECK(fifoPushUnique(b, (void*) 1, 0, key, false) == 0); //flush forgot them
+    free(fifoBufferClose(b));
+}
+
+static void checkMerge(void) 
+{
+    fifo_buffer_t* b = uniqueBuffer(FIFO_DEDUP_EXACT, sum);
+    CHECK(fifoPushUnique(b, (void*) 1, 0, 42, false) == 0);
+    CHECK(fifoPush(b, (void*) 100, 0, false) == 0); //no key: never a duplicate
+    CHECK(fifoPushUnique(b, (void*) 2, 0, 42, false) == EEXIST);
+    CHECK(fifoPushUnique(b, (void*) 4, 5, 42, false) == EEXIST); //priority of the queued item is kept
+    CHECK(fifoPull(b, false) == (void*) 7);
+    CHECK(fifoPull(b, false) == (void*) 100);
+
+    fifo_stats_t stats;
+    CHECK(fifoGetStats(b, &stats) == 0);
+    CHECK(stats.duplicates == 2 && stats.pushes == 2);
+    free(fifoBufferClose(b));
+}
+
+static void checkFilter(void) 
+{
+    fifo_buffer_t* b = uniqueBuffer(FIFO_DEDUP_FILTER, NULL);
+    for (int round = 0; round < 3; round++) 
+    {
+        int fresh = 0;
+        for (uint64_t key = 0; key < CAPACITY; key++) 
+        {
+            uint64_t k = key * 0x9E3779B97F4A7C15ull + (uint64_t) round;
+            int status = fifoPushUnique(b, (void*) 1, 0, k, false);
+            CHECK(status == 0 || status == EEXIST); //false positives are allowed
+            if (status == 0) fresh++;
+            CHECK(fifoPushUnique(b, (void*) 1, 0, k, false) == EEXIST); //no false negatives
+        }
+        CHECK(fresh > CAPACITY / 2);
+        void** out = fifoFlush(b, true);
+        CHECK(out != NULL);
+        free(out);
+    }
+    free(fifoBufferClose(b));
+}
+
+static void* pushAll(void* arg) 
+{
+    (void) arg;
+    for (uint64_t key = 0; key < CAPACITY; key++) 
+    {
+        int status = fifoPushUnique(buffer, (void*) (intptr_t) (key + 1), 0, key, true);
+        CHECK(status == 0 || status == EEXIST);
+        if (status == 0) atomic_fetch_add(&accepted, 1);
+    }
+    return NULL;
+}
+
+int main(void) 
+{
+    fifo_buffer_t* plain = fifoBufferInit(CAPACITY, NULL);
+    CHECK(plain != NULL);
+    CHECK(fifoPushUnique(plain, (void*) 1, 0, 1, false) == ENOTSUP);
+    free(fifoBufferClose(plain));
+
+    checkExactAgainstModel();
+    checkMerge();
+    checkFilter();
+
+    buffer = uniqueBuffer(FIFO_DEDUP_EXACT, NULL);
+    atomic_init(&accepted, 0);
+    pthread_t ids[THREADS];
+    for (int i = 0; i < THREADS; i++) CHECK(pthread_create(&ids[i], NULL, pushAll, NULL) == 0);
+    for (int i = 0; i < THREADS; i++) pthread_join(ids[i], NULL);
+    CHECK(atomic_load(&accepted) == CAPACITY);
+    void** out = fifoFlush(buffer, true);
+    CHECK(out != NULL);
+    int count = 0;
+    while (out[count] != NULL) count++;
+    CHECK(count == CAPACITY);
+    free(out);
+
+    free(fifoBufferClose(buffer));
+    printf("test_unique: ok\n");
+    return 0;
+}